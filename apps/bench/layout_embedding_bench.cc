@@ -0,0 +1,589 @@
+/**
+  * Benchmarks of the library hot paths:
+  *
+  *     find_shortest_path               Shortest paths of all layout edges in the empty embedding
+  *     detect_candidate_path_conflicts  Conflict detection between the candidate paths of all layout edges
+  *     embedding_state_copy             Copying the root EmbeddingState of branch-and-bound
+  *     harmonic_uniform                 harmonic() on the target mesh, constrained at the landmarks
+  *     harmonic_mean_value              Same, with mean value weights
+  *     smooth_paths                     One smoothing iteration of a complete (greedy) embedding
+  *     embed_greedy                     End-to-end greedy embedding
+  *     branch_and_bound                 Branch-and-bound with a fixed iteration budget (--bnb-iterations)
+  *
+  * Every benchmark is run on each workload of a sweep over the target mesh size and the layout size (edge count).
+  * By default, workloads are synthetic (see SyntheticWorkload.hh), so the benchmarks run without any data files.
+  * Alternatively, layouts are decimated from a given target mesh (--target), which can also be refined by subdivision.
+  *
+  * Results are written as JSON with one result object per line, so reports of two commits can be diffed directly.
+  * Passing a previous report via --compare prints the change of the median per benchmark
+  * and fails if any benchmark got slower by more than --threshold.
+  *
+  * Output files can be found in <build-folder>/output/layout_embedding_bench.
+  */
+
+#include <LayoutEmbedding/BranchAndBound.hh>
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/EmbeddingInput.hh>
+#include <LayoutEmbedding/EmbeddingState.hh>
+#include <LayoutEmbedding/Greedy.hh>
+#include <LayoutEmbedding/Harmonic.hh>
+#include <LayoutEmbedding/LayoutGeneration.hh>
+#include <LayoutEmbedding/MeshIO.hh>
+#include <LayoutEmbedding/PathSmoothing.hh>
+#include <LayoutEmbedding/SyntheticWorkload.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/Json.hh>
+#include <LayoutEmbedding/Util/StackTrace.hh>
+#include <LayoutEmbedding/Util/Timer.hh>
+
+#include <cxxopts.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace LayoutEmbedding;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+/// Version of the report format
+constexpr int report_version = 1;
+
+struct BenchSettings
+{
+    int warmup = 1;
+    int repetitions = 5;
+    int bnb_iterations = 1000; // Fixed amount of work, so the runtime reflects throughput
+    double bnb_time_limit = 300.0; // Safety net only. Runs that hit it are flagged via the time_limit_reached counter.
+    std::string filter; // Only run benchmarks whose name contains this
+};
+
+/// A layout and target mesh on which all benchmarks are run
+struct Workload
+{
+    std::string name;
+    std::unique_ptr<EmbeddingInput> input; // Referenced by the embeddings
+    std::unique_ptr<Embedding> em; // Empty embedding of the (subdivided) target mesh
+
+    int layout_vertices = 0;
+    int layout_edges = 0;
+    int subdivisions = 0;
+    int target_vertices = 0;
+    int target_faces = 0;
+};
+
+struct BenchResult
+{
+    std::string name;
+    std::string workload;
+    std::vector<double> samples; // Seconds
+    std::map<std::string, double> counters; // Benchmark-specific values, averaged over the repetitions
+
+    double mean = 0.0;
+    double stddev = 0.0; // Sample standard deviation
+    double min = 0.0;
+    double median = 0.0;
+    double max = 0.0;
+};
+
+/// Wraps the input into a workload, after subdividing the target mesh _subdivisions times.
+Workload make_workload(std::unique_ptr<EmbeddingInput> _input, const std::string& _prefix, const int _subdivisions)
+{
+    Workload w;
+    w.input = std::move(_input);
+
+    Embedding em(*w.input);
+    w.em = std::make_unique<Embedding>(subdivide(em, _subdivisions));
+
+    w.layout_vertices = w.input->l_m.vertices().size();
+    w.layout_edges = w.input->l_m.edges().size();
+    w.subdivisions = _subdivisions;
+    w.target_vertices = w.em->target_mesh().vertices().size();
+    w.target_faces = w.em->target_mesh().faces().size();
+    w.name = _prefix + "_t" + std::to_string(w.target_vertices) + "_e" + std::to_string(w.layout_edges);
+    if (_subdivisions > 0) {
+        w.name += "_s" + std::to_string(_subdivisions);
+    }
+    return w;
+}
+
+/// Layout with (about) _layout_edges edges, decimated from the target mesh of _base.
+Workload file_workload(const EmbeddingInput& _base, const std::string& _prefix, const int _layout_edges, const int _subdivisions)
+{
+    auto input = std::make_unique<EmbeddingInput>(_base);
+    make_layout_by_decimation(*input, layout_vertices_for_edges(input->t_m, _layout_edges));
+    find_matching_vertices_by_proximity(*input);
+    return make_workload(std::move(input), _prefix, _subdivisions);
+}
+
+Workload synthetic_workload(const SyntheticWorkloadSettings& _settings, const int _subdivisions)
+{
+    auto input = std::make_unique<EmbeddingInput>();
+    make_synthetic_workload(*input, _settings);
+    return make_workload(std::move(input), to_string(_settings.shape), _subdivisions);
+}
+
+void compute_statistics(BenchResult& _r)
+{
+    LE_ASSERT(!_r.samples.empty());
+    const int n = _r.samples.size();
+
+    double sum = 0.0;
+    for (const double s : _r.samples) {
+        sum += s;
+    }
+    _r.mean = sum / n;
+
+    double sum_sqr = 0.0;
+    for (const double s : _r.samples) {
+        sum_sqr += (s - _r.mean) * (s - _r.mean);
+    }
+    _r.stddev = n > 1 ? std::sqrt(sum_sqr / (n - 1)) : 0.0;
+
+    auto sorted = _r.samples;
+    std::sort(sorted.begin(), sorted.end());
+    _r.min = sorted.front();
+    _r.max = sorted.back();
+    _r.median = n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+}
+
+/// Runs _setup (untimed) and _run (timed) warmup + repetitions times.
+/// _run may add to the counters, which are averaged over the timed repetitions.
+BenchResult run_benchmark(
+        const std::string& _name,
+        const Workload& _workload,
+        const BenchSettings& _settings,
+        const std::function<void()>& _setup,
+        const std::function<void(std::map<std::string, double>&)>& _run)
+{
+    BenchResult r;
+    r.name = _name;
+    r.workload = _workload.name;
+
+    std::cout << "Running " << _name << " on " << _workload.name << " ..." << std::endl;
+
+    std::map<std::string, double> warmup_counters;
+    for (int i = 0; i < _settings.warmup; ++i) {
+        _setup();
+        _run(warmup_counters);
+    }
+    for (int i = 0; i < _settings.repetitions; ++i) {
+        _setup();
+        Timer timer;
+        _run(r.counters);
+        r.samples.push_back(timer.elapsed_seconds());
+    }
+    for (auto& counter : r.counters) {
+        counter.second /= _settings.repetitions;
+    }
+
+    compute_statistics(r);
+    return r;
+}
+
+bool selected(const std::string& _name, const BenchSettings& _settings)
+{
+    return _settings.filter.empty() || _name.find(_settings.filter) != std::string::npos;
+}
+
+void run_benchmarks(const Workload& _w, const BenchSettings& _settings, std::vector<BenchResult>& _results)
+{
+    const Embedding& base = *_w.em;
+
+    if (selected("find_shortest_path", _settings)) {
+        _results.push_back(run_benchmark("find_shortest_path", _w, _settings, [] { }, [&] (auto& _counters) {
+            for (const auto l_e : base.layout_mesh().edges()) {
+                const auto path = base.find_shortest_path(l_e);
+                _counters["path_vertices"] += path.size();
+            }
+        }));
+    }
+
+    BranchAndBoundSettings bnb_settings;
+    bnb_settings.print_current_insertion_sequence = false;
+    bnb_settings.print_memory_footprint_estimate = false;
+    bnb_settings.time_limit = _settings.bnb_time_limit;
+    bnb_settings.max_iterations = _settings.bnb_iterations;
+
+    if (selected("detect_candidate_path_conflicts", _settings)) {
+        EmbeddingState es(base, bnb_settings);
+        es.compute_all_candidate_paths();
+        _results.push_back(run_benchmark("detect_candidate_path_conflicts", _w, _settings, [] { }, [&] (auto& _counters) {
+            es.detect_candidate_path_conflicts();
+            _counters["conflicting_edges"] += es.conflicting_edges().size();
+        }));
+    }
+
+    if (selected("embedding_state_copy", _settings)) {
+        EmbeddingState es(base, bnb_settings);
+        es.compute_all_candidate_paths();
+        es.detect_candidate_path_conflicts();
+        std::unique_ptr<EmbeddingState> copy;
+        _results.push_back(run_benchmark("embedding_state_copy", _w, _settings, [&] { copy.reset(); }, [&] (auto&) {
+            copy = std::make_unique<EmbeddingState>(es);
+        }));
+    }
+
+    const auto run_harmonic = [&] (const std::string& _name, const LaplaceWeights _weights) {
+        if (!selected(_name, _settings)) {
+            return;
+        }
+        const auto& t_m = base.target_mesh();
+        const auto& t_pos = base.target_pos();
+        auto constrained = t_m.vertices().make_attribute<bool>(false);
+        Eigen::MatrixXd constraint_values = Eigen::MatrixXd::Zero(t_m.vertices().size(), 3);
+        for (const auto l_v : base.layout_mesh().vertices()) {
+            const auto t_v = base.matching_target_vertex(l_v);
+            constrained[t_v] = true;
+            constraint_values.row(t_v.idx.value) = Eigen::Vector3d(t_pos[t_v].x, t_pos[t_v].y, t_pos[t_v].z);
+        }
+        Eigen::MatrixXd res;
+        _results.push_back(run_benchmark(_name, _w, _settings, [] { }, [&] (auto& _counters) {
+            const bool success = harmonic(t_pos, constrained, constraint_values, res, _weights, true);
+            _counters["failures"] += success ? 0.0 : 1.0;
+        }));
+    };
+    run_harmonic("harmonic_uniform", LaplaceWeights::Uniform);
+    run_harmonic("harmonic_mean_value", LaplaceWeights::MeanValue);
+
+    if (selected("smooth_paths", _settings)) {
+        Embedding em_complete = base;
+        embed_greedy(em_complete);
+        if (em_complete.is_complete()) {
+            _results.push_back(run_benchmark("smooth_paths", _w, _settings, [] { }, [&] (auto& _counters) {
+                const auto em_smooth = smooth_paths(em_complete);
+                _counters["cost"] += em_smooth.total_embedded_path_length();
+            }));
+        }
+        else {
+            std::cout << "Skipping smooth_paths on " << _w.name << ": Greedy embedding is not complete." << std::endl;
+        }
+    }
+
+    std::unique_ptr<Embedding> em;
+    const auto fresh_copy = [&] { em = std::make_unique<Embedding>(base); };
+
+    if (selected("embed_greedy", _settings)) {
+        _results.push_back(run_benchmark("embed_greedy", _w, _settings, fresh_copy, [&] (auto& _counters) {
+            const auto result = embed_greedy(*em);
+            _counters["cost"] += result.cost;
+        }));
+    }
+
+    if (selected("branch_and_bound", _settings)) {
+        _results.push_back(run_benchmark("branch_and_bound", _w, _settings, fresh_copy, [&] (auto& _counters) {
+            const auto result = branch_and_bound(*em, bnb_settings);
+            _counters["iterations"] += result.num_iters;
+            _counters["cost"] += result.cost;
+            _counters["gap"] += result.gap;
+            // Neither converged nor used up the budget
+            const bool time_limit_reached = result.num_iters < _settings.bnb_iterations && result.gap > bnb_settings.optimality_gap;
+            _counters["time_limit_reached"] += time_limit_reached ? 1.0 : 0.0;
+        }));
+    }
+}
+
+void write_report(
+        const fs::path& _path,
+        const std::string& _source,
+        const BenchSettings& _settings,
+        const std::vector<Workload>& _workloads,
+        const std::vector<BenchResult>& _results)
+{
+    std::ofstream f(_path);
+    if (!f.is_open()) {
+        LE_ERROR_THROW("Could not open " << _path);
+    }
+
+    int num_threads = 1;
+#ifdef _OPENMP
+    num_threads = omp_get_max_threads();
+#endif
+
+    f << "{\n";
+    f << "\"version\":" << report_version << ",\n";
+    f << "\"source\":" << json_string(_source) << ",\n";
+    f << "\"warmup\":" << _settings.warmup << ",\n";
+    f << "\"repetitions\":" << _settings.repetitions << ",\n";
+    f << "\"bnb_iterations\":" << _settings.bnb_iterations << ",\n";
+    f << "\"bnb_time_limit\":" << json_number(_settings.bnb_time_limit) << ",\n";
+    f << "\"omp_threads\":" << num_threads << ",\n";
+    f << "\"hardware_threads\":" << std::thread::hardware_concurrency() << ",\n";
+
+    f << "\"workloads\":[\n";
+    for (int i = 0; i < (int)_workloads.size(); ++i) {
+        const auto& w = _workloads[i];
+        f << "{\"name\":" << json_string(w.name)
+          << ",\"layout_vertices\":" << w.layout_vertices
+          << ",\"layout_edges\":" << w.layout_edges
+          << ",\"subdivisions\":" << w.subdivisions
+          << ",\"target_vertices\":" << w.target_vertices
+          << ",\"target_faces\":" << w.target_faces
+          << "}" << (i + 1 < (int)_workloads.size() ? "," : "") << "\n";
+    }
+    f << "],\n";
+
+    f << "\"results\":[\n";
+    for (int i = 0; i < (int)_results.size(); ++i) {
+        const auto& r = _results[i];
+        f << "{\"name\":" << json_string(r.name)
+          << ",\"workload\":" << json_string(r.workload)
+          << ",\"mean\":" << json_number(r.mean)
+          << ",\"stddev\":" << json_number(r.stddev)
+          << ",\"min\":" << json_number(r.min)
+          << ",\"median\":" << json_number(r.median)
+          << ",\"max\":" << json_number(r.max)
+          << ",\"samples\":[";
+        for (int j = 0; j < (int)r.samples.size(); ++j) {
+            f << (j ? "," : "") << json_number(r.samples[j]);
+        }
+        f << "],\"counters\":{";
+        bool first = true;
+        for (const auto& counter : r.counters) {
+            f << (first ? "" : ",") << json_string(counter.first) << ":" << json_number(counter.second);
+            first = false;
+        }
+        f << "}}" << (i + 1 < (int)_results.size() ? "," : "") << "\n";
+    }
+    f << "]\n";
+    f << "}\n";
+}
+
+/// Prints the change of the median w.r.t. a previous report.
+/// Returns the number of benchmarks that got slower by more than _threshold (relative).
+int compare_to_baseline(const fs::path& _baseline_path, const std::vector<BenchResult>& _results, const double _threshold)
+{
+    std::ifstream f(_baseline_path);
+    if (!f.is_open()) {
+        LE_ERROR_THROW("Could not open baseline " << _baseline_path);
+    }
+
+    std::map<std::pair<std::string, std::string>, double> baseline; // (name, workload) -> median
+    std::string line;
+    while (std::getline(f, line)) {
+        const std::string name = read_json_field(line, "name");
+        const std::string workload = read_json_field(line, "workload");
+        const std::string median = read_json_field(line, "median");
+        if (name.empty() || workload.empty() || median.empty() || median == "null") {
+            continue;
+        }
+        baseline[{name, workload}] = std::stod(median);
+    }
+
+    int num_regressions = 0;
+    std::cout << std::endl;
+    std::cout << "Comparison to " << _baseline_path << " (median):" << std::endl;
+    for (const auto& r : _results) {
+        std::cout << "    " << std::left << std::setw(34) << r.name << std::setw(24) << r.workload << std::right;
+        const auto it = baseline.find({r.name, r.workload});
+        if (it == baseline.end() || it->second <= 0.0) {
+            std::cout << "  (no baseline)" << std::endl;
+            continue;
+        }
+        const double change = r.median / it->second - 1.0;
+        std::cout << std::setw(12) << it->second << " s -> " << std::setw(12) << r.median << " s  "
+                  << std::showpos << std::fixed << std::setprecision(1) << 100.0 * change << " %" << std::noshowpos << std::defaultfloat;
+        if (change > _threshold) {
+            std::cout << "  REGRESSION";
+            ++num_regressions;
+        }
+        std::cout << std::endl;
+    }
+    return num_regressions;
+}
+
+std::vector<int> parse_int_list(const std::string& _s, const std::string& _option)
+{
+    std::vector<int> result;
+    std::istringstream ss(_s);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        try {
+            result.push_back(std::stoi(token));
+        }
+        catch (...) {
+            throw cxxopts::OptionException("Invalid value for " + _option + ": " + _s);
+        }
+    }
+    if (result.empty()) {
+        throw cxxopts::OptionException("Empty list for " + _option);
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    register_segfault_handler();
+
+    BenchSettings settings;
+    fs::path target_path;
+    fs::path report_path;
+    fs::path baseline_path;
+    SyntheticWorkloadSettings synthetic_settings;
+    std::vector<int> target_sizes;
+    std::vector<int> layout_sizes;
+    std::vector<int> subdivision_levels;
+    double threshold = 0.1;
+
+    const fs::path output_dir = fs::path(LE_OUTPUT_PATH) / "layout_embedding_bench";
+
+    cxxopts::Options opts("layout_embedding_bench",
+        "Benchmarks of the library hot paths on a sweep over layout and target mesh sizes.\n"
+        "See the top of layout_embedding_bench.cc for the list of benchmarks.\n"
+        "\n"
+        "Output files are written to <build-folder>/output/layout_embedding_bench.\n");
+    opts.add_options()("shape", "Synthetic target shape: sphere, torus, bumpy, elongated.", cxxopts::value<std::string>()->default_value("sphere"));
+    opts.add_options()("n,target-vertices", "Comma-separated list of (approximate) synthetic target vertex counts.", cxxopts::value<std::string>()->default_value("2000,8000"));
+    opts.add_options()("seed", "Seed of the synthetic workloads.", cxxopts::value<int>()->default_value("0"));
+    opts.add_options()("jitter", "Number of random steps each landmark is moved away from the closest target vertex.", cxxopts::value<int>()->default_value("0"));
+    opts.add_options()("target", "Path to a target mesh to use instead of synthetic ones. Layouts are generated by decimating it.", cxxopts::value<std::string>()->default_value(""));
+    opts.add_options()("e,layout-edges", "Comma-separated list of (approximate) layout edge counts.", cxxopts::value<std::string>()->default_value("18,42,90"));
+    opts.add_options()("s,subdivisions", "Comma-separated list of target mesh subdivision steps.", cxxopts::value<std::string>()->default_value("0"));
+    opts.add_options()("f,filter", "Only run benchmarks whose name contains this string.", cxxopts::value<std::string>()->default_value(""));
+    opts.add_options()("w,warmup", "Number of untimed warmup runs per benchmark.", cxxopts::value<int>()->default_value("1"));
+    opts.add_options()("r,repetitions", "Number of timed runs per benchmark.", cxxopts::value<int>()->default_value("5"));
+    opts.add_options()("bnb-iterations", "Number of branch-and-bound iterations per run.", cxxopts::value<int>()->default_value("1000"));
+    opts.add_options()("bnb-time-limit", "Time limit of branch-and-bound in seconds (safety net, should not be reached).", cxxopts::value<double>()->default_value("300"));
+    opts.add_options()("t,threads", "Number of OpenMP threads (default: OpenMP default).", cxxopts::value<int>()->default_value("0"));
+    opts.add_options()("o,output", "Path to the report file.", cxxopts::value<std::string>()->default_value((output_dir / "report.json").string()));
+    opts.add_options()("c,compare", "Path to a previous report to compare against.", cxxopts::value<std::string>()->default_value(""));
+    opts.add_options()("threshold", "Relative slowdown of the median reported as regression.", cxxopts::value<double>()->default_value("0.1"));
+    opts.add_options()("h,help", "Help.");
+    try {
+        auto args = opts.parse(argc, argv);
+        if (args.count("help")) {
+            std::cout << opts.help() << std::endl;
+            return 0;
+        }
+
+        if (!parse_synthetic_shape(args["shape"].as<std::string>(), synthetic_settings.shape)) {
+            throw cxxopts::OptionException("Unknown shape: " + args["shape"].as<std::string>());
+        }
+        synthetic_settings.seed = args["seed"].as<int>();
+        synthetic_settings.jitter_steps = args["jitter"].as<int>();
+        target_sizes = parse_int_list(args["target-vertices"].as<std::string>(), "target-vertices");
+        target_path = args["target"].as<std::string>();
+        layout_sizes = parse_int_list(args["layout-edges"].as<std::string>(), "layout-edges");
+        subdivision_levels = parse_int_list(args["subdivisions"].as<std::string>(), "subdivisions");
+        settings.filter = args["filter"].as<std::string>();
+        settings.warmup = args["warmup"].as<int>();
+        settings.repetitions = args["repetitions"].as<int>();
+        settings.bnb_iterations = args["bnb-iterations"].as<int>();
+        settings.bnb_time_limit = args["bnb-time-limit"].as<double>();
+        report_path = args["output"].as<std::string>();
+        baseline_path = args["compare"].as<std::string>();
+        threshold = args["threshold"].as<double>();
+
+        if (settings.warmup < 0 || settings.repetitions < 1) {
+            throw cxxopts::OptionException("Need at least one repetition and a non-negative number of warmup runs");
+        }
+        if (settings.bnb_iterations < 1) {
+            throw cxxopts::OptionException("Need at least one branch-and-bound iteration");
+        }
+        for (const int n : target_sizes) {
+            if (n < 12) {
+                throw cxxopts::OptionException("Target meshes need at least 12 vertices");
+            }
+        }
+        for (const int n : layout_sizes) {
+            if (n < 6) {
+                throw cxxopts::OptionException("Layouts need at least 6 edges");
+            }
+        }
+        for (const int n : subdivision_levels) {
+            if (n < 0) {
+                throw cxxopts::OptionException("Invalid number of subdivisions: " + std::to_string(n));
+            }
+        }
+
+        const int num_threads = args["threads"].as<int>();
+        if (num_threads > 0) {
+#ifdef _OPENMP
+            omp_set_num_threads(num_threads);
+#endif
+        }
+    }
+    catch (const cxxopts::OptionException& e) {
+        std::cout << e.what() << std::endl << std::endl;
+        std::cout << opts.help() << std::endl;
+        return 1;
+    }
+
+    std::vector<Workload> workloads;
+    std::string source;
+    if (target_path.empty()) {
+        source = "synthetic:" + to_string(synthetic_settings.shape)
+                + ",seed=" + std::to_string(synthetic_settings.seed)
+                + ",jitter=" + std::to_string(synthetic_settings.jitter_steps);
+        for (const int n_target : target_sizes) {
+            for (const int n_layout : layout_sizes) {
+                for (const int k : subdivision_levels) {
+                    auto ws = synthetic_settings;
+                    ws.target_vertices = n_target;
+                    ws.layout_edges = n_layout;
+                    workloads.push_back(synthetic_workload(ws, k));
+                }
+            }
+        }
+    }
+    else {
+        source = target_path.string();
+        EmbeddingInput base;
+        if (!load_mesh(target_path, base.t_m, base.t_pos)) {
+            std::cout << "Could not load target mesh " << target_path << std::endl;
+            return 1;
+        }
+        for (const int n_layout : layout_sizes) {
+            for (const int k : subdivision_levels) {
+                workloads.push_back(file_workload(base, target_path.stem().string(), n_layout, k));
+            }
+        }
+    }
+
+    std::vector<BenchResult> results;
+    for (const auto& w : workloads) {
+        std::cout << "Workload " << w.name << ": "
+                  << w.layout_vertices << " layout vertices, "
+                  << w.layout_edges << " layout edges, "
+                  << w.target_vertices << " target vertices" << std::endl;
+        run_benchmarks(w, settings, results);
+    }
+
+    fs::create_directories(fs::absolute(report_path).parent_path());
+    write_report(report_path, source, settings, workloads, results);
+
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(34) << "Benchmark" << std::setw(24) << "Workload" << std::right
+              << std::setw(12) << "Median [s]" << std::setw(12) << "Mean [s]" << std::setw(12) << "Stddev [s]" << std::endl;
+    for (const auto& r : results) {
+        std::cout << std::left << std::setw(34) << r.name << std::setw(24) << r.workload << std::right
+                  << std::setw(12) << r.median << std::setw(12) << r.mean << std::setw(12) << r.stddev << std::endl;
+    }
+    std::cout << std::endl << "Report written to " << report_path << std::endl;
+
+    if (!baseline_path.empty()) {
+        const int num_regressions = compare_to_baseline(baseline_path, results, threshold);
+        if (num_regressions > 0) {
+            std::cout << num_regressions << " regression(s) above " << 100.0 * threshold << " %" << std::endl;
+            return 2;
+        }
+    }
+
+    return 0;
+}
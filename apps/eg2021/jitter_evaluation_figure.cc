@@ -71,13 +71,9 @@ int main(int argc, char** argv)
         matching_target_vertices.push_back(t_v);
     }
 
-    auto geodesic_distance = input.l_m.vertices().make_attribute<std::vector<double>>();
-    for (const auto l_v : input.l_m.vertices()) {
-        const auto& t_v = input.l_matching_vertex[l_v];
-        auto da = approximate_geodesic_distance(input.t_pos, t_v);
-        auto d = da.to_vector();
-        geodesic_distance[l_v] = d;
-    }
+    // Row i: distances from the target vertex matching the i-th layout vertex
+    const GeodesicDistanceSolver geodesic_solver(input.t_pos);
+    const auto geodesic_distance = geodesic_solver.solve_each(matching_target_vertices);
 
     const fs::path stats_path = jitter_evaluation_output_dir / "stats.csv";
     fs::create_directories(jitter_evaluation_output_dir);
@@ -148,7 +144,7 @@ int main(int argc, char** argv)
             double sum_d = 0.0;
             for (const auto l_v : jittered_input.l_m.vertices()) {
                 const auto& t_v = jittered_input.l_matching_vertex[l_v];
-                const auto d = geodesic_distance[l_v.idx][t_v.idx.value];
+                const auto d = geodesic_distance(l_v.idx.value, t_v);
                 max_d = std::max(max_d, d);
                 sum_d += d;
             }
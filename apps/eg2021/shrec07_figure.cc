@@ -386,6 +386,7 @@ void view(const fs::path& path, const std::optional<ViewSettings>& settings, con
             p = tg::rotate_x(p, tg::angle::from_degree(settings->rotation_euler[1]));
             p = tg::rotate_x(p, tg::angle::from_degree(settings->rotation_euler[2]));
         });
+        em.invalidate_caches();
     }
 
     auto style = default_style();
@@ -13,6 +13,7 @@
 #include <typed-geometry/tg.hh>
 
 #include <LayoutEmbedding/EmbeddingInput.hh>
+#include <LayoutEmbedding/MeshIO.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
 #include <LayoutEmbedding/Util/StackTrace.hh>
 
@@ -74,7 +75,7 @@ int main()
             // Load mesh
             EmbeddingInput input;
 
-            pm::load(mesh_path, input.t_m, input.t_pos);
+            load_mesh(mesh_path, input.t_m, input.t_pos);
             std::cout << "Target Mesh: ";
             std::cout << input.t_m.vertices().size() << " vertices, ";
             std::cout << input.t_m.edges().size() << " edges, ";
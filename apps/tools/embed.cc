@@ -4,16 +4,26 @@
 
 #include <LayoutEmbedding/Greedy.hh>
 #include <LayoutEmbedding/BranchAndBound.hh>
+#include <LayoutEmbedding/EmbeddingInput.hh>
 #include <LayoutEmbedding/PathSmoothing.hh>
+#include <LayoutEmbedding/Util/StackTrace.hh>
+
+#ifdef LE_WITH_VISUALIZATION
 #include <LayoutEmbedding/Visualization/Visualization.hh>
+#endif
 
 #include <cxxopts.hpp>
 
+#include <filesystem>
+#include <set>
+
 using namespace LayoutEmbedding;
 namespace fs = std::filesystem;
 
+#ifdef LE_WITH_VISUALIZATION
 const auto screenshot_size = tg::ivec2(1920, 1080);
 const int screenshot_samples = 64;
+#endif
 
 int main(int argc, char** argv)
 {
@@ -24,6 +34,7 @@ int main(int argc, char** argv)
     std::string algo = "bnb";
     bool smooth = false;
     bool open_viewer = false;
+    bool compute_only = false;
 
     cxxopts::Options opts("embed",
         "Embeds a given layout into a target mesh.\n"
@@ -31,6 +42,7 @@ int main(int argc, char** argv)
         "Layout vertices are projected to target surface to define landmark positions.\n"
         "\n"
         "Output files are written to <build-folder>/output/embed.\n"
+        "Unless in compute-only mode, a screenshot of the result is saved as well.\n"
         "\n"
         "Supported algorithms are:\n"
         "    bnb:       Branch-and-bound algorithm (default)\n"
@@ -43,6 +55,7 @@ int main(int argc, char** argv)
     opts.add_options()("a,algo", "Algorithm, one of: bnb, greedy, praun, kraevoy, schreiner.", cxxopts::value<std::string>()->default_value("bnb"));
     opts.add_options()("s,smooth", "Apply smoothing post-process based on [Praun2001].", cxxopts::value<bool>());
     opts.add_options()("v,viewer", "Open a window to inspect the resulting embedding.", cxxopts::value<bool>());
+    opts.add_options()("c,compute-only", "Only compute and save the embedding. No screenshot, no window system required.", cxxopts::value<bool>());
     opts.add_options()("h,help", "Help.");
     opts.parse_positional({"layout", "target"});
     opts.positional_help("[layout] [target]");
@@ -61,6 +74,16 @@ int main(int argc, char** argv)
 
         smooth = args["smooth"].as<bool>();
         open_viewer = args["viewer"].as<bool>();
+        compute_only = args["compute-only"].as<bool>();
+#ifndef LE_WITH_VISUALIZATION
+        if (open_viewer) {
+            throw cxxopts::OptionException("The viewer is not available: built without visualization (LE_BUILD_VISUALIZATION=OFF).");
+        }
+        compute_only = true; // Built without visualization
+#endif
+        if (compute_only && open_viewer) {
+            throw cxxopts::OptionException("The viewer is not available in compute-only mode.");
+        }
 
         if (args.count("help") || args.count("layout") == 0 || args.count("target") == 0) {
             std::cout << opts.help() << std::endl;
@@ -73,27 +96,29 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    glow::glfw::GlfwContext ctx;
-
     // Load input
     EmbeddingInput input;
     input.load(layout_path, target_path);
 
     // Compute embedding
     Embedding em(input);
+    Profile profile; // Only filled if the library was built with LE_ENABLE_PROFILING
     if (algo == "greedy")
-        embed_greedy(em);
+        profile = embed_greedy(em).profile;
     else if (algo == "praun")
-        embed_praun(em);
+        profile = embed_praun(em).profile;
     else if (algo == "kraevoy")
-        embed_kraevoy(em);
+        profile = embed_kraevoy(em).profile;
     else if (algo == "schreiner")
-        embed_schreiner(em);
+        profile = embed_schreiner(em).profile;
     else if (algo == "bnb")
-        branch_and_bound(em);
+        profile = branch_and_bound(em).profile;
     else
         LE_ASSERT(false);
 
+    if (!profile.empty())
+        profile.print();
+
     // Smooth embedding
     if (smooth)
         em = smooth_paths(em);
@@ -103,6 +128,13 @@ int main(int argc, char** argv)
     fs::create_directories(output_dir);
     em.save(output_dir / target_path.stem());
 
+#ifdef LE_WITH_VISUALIZATION
+    if (compute_only) {
+        return 0;
+    }
+
+    glow::glfw::GlfwContext ctx;
+
     // Save screenshot
     {
         auto style = default_style();
@@ -116,4 +148,5 @@ int main(int argc, char** argv)
         auto style = default_style();
         view_embedding(em);
     }
+#endif
 }
@@ -0,0 +1,509 @@
+/**
+  * Runs a batch of embedding jobs, listed in a manifest file, on a pool of worker threads.
+  *
+  * Manifest format: One job per line, given as whitespace-separated key=value pairs.
+  * Empty lines and everything after a '#' are ignored. Relative paths are relative to the manifest.
+  *
+  *     id=1_bnb layout=layouts/1.obj target=meshes/1.off landmarks=corrs/1.vts algo=bnb time_limit=300 normalize=1
+  *
+  * Keys:
+  *     id:               Unique job name (default: <target stem>_<algo>)
+  *     layout, target:   Mesh files (required)
+  *     landmarks:        Landmark file. If omitted, layout vertices are projected to the target surface.
+  *     landmark_format:  id_x_y_z (default) or id
+  *     algo:             bnb (default), greedy, praun, kraevoy, schreiner
+  *     time_limit:       Time limit of bnb in seconds
+  *     normalize:        Normalize the target surface area and center the input (0 or 1)
+  *     invert_layout:    Reverse the face orientation of the layout (0 or 1)
+  *     smooth:           Apply path smoothing after embedding (0 or 1)
+  *
+  * Each finished job appends one JSON object (one line) to the report.
+  * When restarted on an existing report, jobs that already have an entry are skipped.
+  * A job run again via --retry-failed appends a second entry with the same id. Once all workers are done,
+  * the report is compacted so that only the last entry per id remains.
+  * Console output of the library (e.g. branch-and-bound progress) is discarded unless --verbose is given,
+  * since the output of concurrent jobs would be interleaved. Errors of failed jobs are part of the report.
+  * A failing job (e.g. a failed assertion) is reported and does not affect the other jobs.
+  *
+  * Output files can be found in <build-folder>/output/embed_batch.
+  */
+
+#include <LayoutEmbedding/BranchAndBound.hh>
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/EmbeddingInput.hh>
+#include <LayoutEmbedding/Greedy.hh>
+#include <LayoutEmbedding/PathSmoothing.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/Json.hh>
+#include <LayoutEmbedding/Util/StackTrace.hh>
+#include <LayoutEmbedding/Util/Timer.hh>
+
+#include <cxxopts.hpp>
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace LayoutEmbedding;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+struct Job
+{
+    int line = 0; // In the manifest
+    std::string id;
+    fs::path layout_path;
+    fs::path target_path;
+    fs::path landmarks_path;
+    LandmarkFormat landmark_format = LandmarkFormat::id_x_y_z;
+    std::string algo = "bnb";
+    double time_limit = -1.0; // Negative: BranchAndBoundSettings default
+    bool normalize = false;
+    bool invert_layout = false;
+    bool smooth = false;
+};
+
+bool parse_flag(const std::string& _value, const std::string& _key)
+{
+    if (_value == "1" || _value == "true") {
+        return true;
+    }
+    if (_value == "0" || _value == "false") {
+        return false;
+    }
+    LE_ERROR_THROW("Invalid value for " << _key << ": " << _value);
+}
+
+std::vector<Job> load_manifest(const fs::path& _path)
+{
+    std::ifstream file(_path);
+    if (!file.is_open()) {
+        LE_ERROR_THROW("Could not open manifest " << _path);
+    }
+
+    const fs::path base_dir = _path.parent_path();
+    auto resolve = [&] (const std::string& _p) {
+        const fs::path p(_p);
+        return p.is_relative() ? base_dir / p : p;
+    };
+
+    const std::set<std::string> valid_algos = { "bnb", "greedy", "praun", "kraevoy", "schreiner" };
+
+    std::vector<Job> jobs;
+    std::set<std::string> ids;
+    std::string line;
+    int line_nr = 0;
+    while (std::getline(file, line)) {
+        ++line_nr;
+        line = line.substr(0, line.find('#'));
+
+        Job job;
+        job.line = line_nr;
+        std::istringstream tokens(line);
+        std::string token;
+        bool empty = true;
+        while (tokens >> token) {
+            empty = false;
+            const auto eq = token.find('=');
+            if (eq == std::string::npos) {
+                LE_ERROR_THROW("Manifest line " << line_nr << ": Expected key=value, got " << token);
+            }
+            const std::string key = token.substr(0, eq);
+            const std::string value = token.substr(eq + 1);
+
+            if (key == "id") {
+                job.id = value;
+            }
+            else if (key == "layout") {
+                job.layout_path = resolve(value);
+            }
+            else if (key == "target") {
+                job.target_path = resolve(value);
+            }
+            else if (key == "landmarks") {
+                job.landmarks_path = resolve(value);
+            }
+            else if (key == "landmark_format") {
+                if (value == "id_x_y_z") {
+                    job.landmark_format = LandmarkFormat::id_x_y_z;
+                }
+                else if (value == "id") {
+                    job.landmark_format = LandmarkFormat::id;
+                }
+                else {
+                    LE_ERROR_THROW("Manifest line " << line_nr << ": Invalid landmark format " << value);
+                }
+            }
+            else if (key == "algo") {
+                if (valid_algos.count(value) == 0) {
+                    LE_ERROR_THROW("Manifest line " << line_nr << ": Invalid algo " << value);
+                }
+                job.algo = value;
+            }
+            else if (key == "time_limit") {
+                job.time_limit = std::stod(value);
+            }
+            else if (key == "normalize") {
+                job.normalize = parse_flag(value, key);
+            }
+            else if (key == "invert_layout") {
+                job.invert_layout = parse_flag(value, key);
+            }
+            else if (key == "smooth") {
+                job.smooth = parse_flag(value, key);
+            }
+            else {
+                LE_ERROR_THROW("Manifest line " << line_nr << ": Unknown key " << key);
+            }
+        }
+        if (empty) {
+            continue;
+        }
+
+        if (job.layout_path.empty() || job.target_path.empty()) {
+            LE_ERROR_THROW("Manifest line " << line_nr << ": layout and target are required");
+        }
+        if (job.id.empty()) {
+            job.id = job.target_path.stem().string() + "_" + job.algo;
+        }
+        if (ids.count(job.id)) {
+            LE_ERROR_THROW("Manifest line " << line_nr << ": Duplicate job id " << job.id);
+        }
+        ids.insert(job.id);
+
+        jobs.push_back(job);
+    }
+    return jobs;
+}
+
+/// Discards everything written to it.
+struct NullBuffer : std::streambuf
+{
+    int overflow(int c) override { return c; }
+};
+
+/// Rewrites the report such that only the last entry of each id remains.
+/// Entries keep the order in which their ids first appeared.
+void compact_report(const fs::path& _path)
+{
+    std::vector<std::string> lines;
+    std::map<std::string, int> line_of_id;
+    {
+        std::ifstream file(_path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty()) {
+                continue;
+            }
+            const auto id = read_json_field(line, "id");
+            if (!id.empty() && line_of_id.count(id)) {
+                lines[line_of_id[id]] = line;
+                continue;
+            }
+            if (!id.empty()) {
+                line_of_id[id] = (int)lines.size();
+            }
+            lines.push_back(line);
+        }
+    }
+
+    // Write to a temporary file first so an interruption does not lose the report
+    fs::path tmp_path = _path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream file(tmp_path, std::ofstream::trunc);
+        if (!file.is_open()) {
+            LE_ERROR_THROW("Could not open " << tmp_path);
+        }
+        for (const auto& line : lines) {
+            file << line << '\n';
+        }
+    }
+    fs::rename(tmp_path, _path);
+}
+
+/// Runs a single job and returns its report line.
+std::string run_job(const Job& _job, const fs::path& _embeddings_dir)
+{
+    // Ordered fields of the report entry
+    std::vector<std::pair<std::string, std::string>> fields;
+    fields.push_back({"id", json_string(_job.id)});
+    fields.push_back({"line", std::to_string(_job.line)});
+    fields.push_back({"algo", json_string(_job.algo)});
+    fields.push_back({"layout", json_string(_job.layout_path.string())});
+    fields.push_back({"target", json_string(_job.target_path.string())});
+
+    std::string status = "ok";
+    std::string error;
+    try {
+        Timer load_timer;
+        EmbeddingInput input;
+        bool loaded;
+        if (_job.landmarks_path.empty()) {
+            loaded = input.load(_job.layout_path, _job.target_path);
+        }
+        else {
+            loaded = input.load(_job.layout_path, _job.target_path, _job.landmarks_path, _job.landmark_format);
+        }
+        if (!loaded) {
+            LE_ERROR_THROW("Could not load input");
+        }
+        if (_job.invert_layout) {
+            input.invert_layout();
+        }
+        if (_job.normalize) {
+            input.normalize_surface_area();
+            input.center_translation();
+        }
+        fields.push_back({"load_time", json_number(load_timer.elapsed_seconds())});
+        fields.push_back({"layout_vertices", std::to_string(input.l_m.vertices().size())});
+        fields.push_back({"layout_edges", std::to_string(input.l_m.edges().size())});
+        fields.push_back({"target_vertices", std::to_string(input.t_m.vertices().size())});
+
+        Embedding em(input);
+        Timer timer;
+        if (_job.algo == "greedy") {
+            embed_greedy(em);
+        }
+        else if (_job.algo == "praun") {
+            embed_praun(em);
+        }
+        else if (_job.algo == "kraevoy") {
+            embed_kraevoy(em);
+        }
+        else if (_job.algo == "schreiner") {
+            embed_schreiner(em);
+        }
+        else if (_job.algo == "bnb") {
+            BranchAndBoundSettings settings;
+            settings.print_current_insertion_sequence = false;
+            settings.print_memory_footprint_estimate = false;
+            if (_job.time_limit >= 0.0) {
+                settings.time_limit = _job.time_limit;
+            }
+            const auto result = branch_and_bound(em, settings);
+
+            double last_upper_bound_event_t = std::numeric_limits<double>::infinity();
+            if (!result.upper_bound_events.empty()) {
+                last_upper_bound_event_t = result.upper_bound_events.back().t;
+            }
+            fields.push_back({"lower_bound", json_number(result.lower_bound)});
+            fields.push_back({"gap", json_number(result.gap)});
+            fields.push_back({"last_upper_bound_event_t", json_number(last_upper_bound_event_t)});
+            fields.push_back({"max_state_tree_memory", json_number(result.max_state_tree_memory_estimate)});
+        }
+        else {
+            LE_ASSERT(false);
+        }
+        fields.push_back({"runtime", json_number(timer.elapsed_seconds())});
+        fields.push_back({"complete", em.is_complete() ? "true" : "false"});
+        fields.push_back({"cost", json_number(em.is_complete() ? em.total_embedded_path_length() : std::numeric_limits<double>::infinity())});
+
+        if (_job.smooth) {
+            Timer smooth_timer;
+            em = smooth_paths(em);
+            fields.push_back({"smoothing_time", json_number(smooth_timer.elapsed_seconds())});
+            fields.push_back({"smoothed_cost", json_number(em.is_complete() ? em.total_embedded_path_length() : std::numeric_limits<double>::infinity())});
+        }
+
+        if (!_embeddings_dir.empty()) {
+            em.save((_embeddings_dir / _job.id).string());
+        }
+    }
+    catch (const std::exception& e) {
+        status = "failed";
+        error = e.what();
+    }
+    catch (...) {
+        status = "failed";
+        error = "Unknown exception";
+    }
+
+    std::ostringstream ss;
+    ss << "{\"status\":" << json_string(status);
+    if (!error.empty()) {
+        ss << ",\"error\":" << json_string(error);
+    }
+    for (const auto& field : fields) {
+        ss << "," << json_string(field.first) << ":" << field.second;
+    }
+    ss << "}";
+    return ss.str();
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    register_segfault_handler();
+
+    fs::path manifest_path;
+    fs::path report_path;
+    int num_workers = 0;
+    int threads_per_job = 1;
+    bool fresh = false;
+    bool retry_failed = false;
+    bool save_embeddings = false;
+    bool verbose = false;
+
+    const fs::path output_dir = fs::path(LE_OUTPUT_PATH) / "embed_batch";
+
+    cxxopts::Options opts("embed_batch",
+        "Runs the embedding jobs listed in a manifest on a pool of worker threads.\n"
+        "See the top of embed_batch.cc for the manifest format.\n"
+        "\n"
+        "Results are appended to a report file with one JSON object per line.\n"
+        "Jobs that already have an entry in the report are skipped, so an interrupted batch can simply be restarted.\n"
+        "When all jobs are done, only the last entry per job id is kept.\n"
+        "\n"
+        "Output files are written to <build-folder>/output/embed_batch.\n");
+    opts.add_options()("m,manifest", "Path to the job manifest.", cxxopts::value<std::string>());
+    opts.add_options()("r,report", "Path to the report file.", cxxopts::value<std::string>()->default_value((output_dir / "report.jsonl").string()));
+    opts.add_options()("j,jobs", "Number of jobs run concurrently (default: cores / threads per job).", cxxopts::value<int>()->default_value("0"));
+    opts.add_options()("t,threads", "Number of OpenMP threads per job.", cxxopts::value<int>()->default_value("1"));
+    opts.add_options()("fresh", "Discard an existing report instead of resuming.", cxxopts::value<bool>());
+    opts.add_options()("retry-failed", "When resuming, run previously failed jobs again.", cxxopts::value<bool>());
+    opts.add_options()("s,save", "Save the resulting embeddings.", cxxopts::value<bool>());
+    opts.add_options()("v,verbose", "Keep the console output of the jobs (interleaved if jobs run concurrently).", cxxopts::value<bool>());
+    opts.add_options()("h,help", "Help.");
+    opts.parse_positional({"manifest"});
+    opts.positional_help("[manifest]");
+    opts.show_positional_help();
+    try {
+        auto args = opts.parse(argc, argv);
+        if (args.count("help") || args.count("manifest") == 0) {
+            std::cout << opts.help() << std::endl;
+            return 0;
+        }
+
+        manifest_path = args["manifest"].as<std::string>();
+        report_path = args["report"].as<std::string>();
+        num_workers = args["jobs"].as<int>();
+        threads_per_job = args["threads"].as<int>();
+        fresh = args["fresh"].as<bool>();
+        retry_failed = args["retry-failed"].as<bool>();
+        save_embeddings = args["save"].as<bool>();
+        verbose = args["verbose"].as<bool>();
+
+        if (threads_per_job < 1) {
+            throw cxxopts::OptionException("Invalid number of threads per job: " + std::to_string(threads_per_job));
+        }
+    }
+    catch (const cxxopts::OptionException& e) {
+        std::cout << e.what() << "\n\n";
+        std::cout << opts.help() << std::endl;
+        return 1;
+    }
+
+    if (num_workers <= 0) {
+        const int num_cores = std::max(1u, std::thread::hardware_concurrency());
+        num_workers = std::max(1, num_cores / threads_per_job);
+    }
+
+    const auto all_jobs = load_manifest(manifest_path);
+
+    // Skip jobs already in the report
+    std::set<std::string> done_ids;
+    if (!fresh && fs::exists(report_path)) {
+        std::ifstream report(report_path);
+        std::string line;
+        while (std::getline(report, line)) {
+            const auto id = read_json_field(line, "id");
+            const auto status = read_json_field(line, "status");
+            if (!id.empty() && (status == "ok" || !retry_failed)) {
+                done_ids.insert(id);
+            }
+        }
+    }
+    std::vector<Job> jobs;
+    for (const auto& job : all_jobs) {
+        if (done_ids.count(job.id) == 0) {
+            jobs.push_back(job);
+        }
+    }
+
+    std::cout << all_jobs.size() << " jobs, " << (all_jobs.size() - jobs.size()) << " already done." << std::endl;
+    std::cout << "Running " << jobs.size() << " jobs on " << num_workers << " workers with " << threads_per_job << " threads each." << std::endl;
+
+    fs::path embeddings_dir;
+    if (save_embeddings) {
+        embeddings_dir = output_dir / "embeddings";
+        fs::create_directories(embeddings_dir);
+    }
+    if (report_path.has_parent_path()) {
+        fs::create_directories(report_path.parent_path());
+    }
+    std::ofstream report(report_path, fresh ? std::ofstream::trunc : std::ofstream::app);
+    if (!report.is_open()) {
+        LE_ERROR_THROW("Could not open report " << report_path);
+    }
+
+    // Progress lines go to the original console, library output is discarded unless verbose
+    std::ostream console(std::cout.rdbuf());
+    NullBuffer null_buffer;
+    if (!verbose) {
+        std::cout.rdbuf(&null_buffer);
+    }
+
+    std::mutex report_mutex;
+    std::atomic<int> next_job = 0;
+    int num_finished = 0;
+    int num_failed = 0;
+
+    auto worker = [&] {
+#ifdef _OPENMP
+        // Applies to parallel regions started from this thread
+        omp_set_num_threads(threads_per_job);
+#endif
+        while (true) {
+            const int i = next_job++;
+            if (i >= (int)jobs.size()) {
+                break;
+            }
+
+            Timer timer;
+            const std::string entry = run_job(jobs[i], embeddings_dir);
+            const bool failed = read_json_field(entry, "status") != "ok";
+
+            std::lock_guard<std::mutex> lock(report_mutex);
+            report << entry << '\n';
+            report.flush(); // Finished jobs survive an interruption of the batch
+            ++num_finished;
+            if (failed) {
+                ++num_failed;
+            }
+            console << "[" << num_finished << "/" << jobs.size() << "] " << jobs[i].id << ": " << (failed ? "failed" : "ok") << " (" << timer.elapsed_seconds() << " s)" << std::endl;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::min(num_workers, (int)jobs.size()); ++i) {
+        workers.emplace_back(worker);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    std::cout.rdbuf(console.rdbuf());
+
+    report.close();
+    compact_report(report_path);
+
+    std::cout << "Done. " << num_failed << " of " << jobs.size() << " jobs failed." << std::endl;
+    std::cout << "Report: " << report_path << std::endl;
+
+    return num_failed == 0 ? 0 : 1;
+}
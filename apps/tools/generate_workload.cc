@@ -0,0 +1,177 @@
+/**
+  * Generates synthetic embedding inputs (target mesh, layout and landmarks) for benchmarks and scaling studies.
+  *
+  * For each combination of shape, target vertex count, layout edge count and seed, writes
+  *     <name>_target.obj, <name>_layout.obj, <name>_landmarks.txt (landmark_format=id)
+  * and appends a job line to manifest.txt, which can be passed to embed_batch.
+  *
+  * Output files can be found in <build-folder>/output/generate_workload.
+  */
+
+#include <LayoutEmbedding/EmbeddingInput.hh>
+#include <LayoutEmbedding/SyntheticWorkload.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/StackTrace.hh>
+#include <LayoutEmbedding/Util/Timer.hh>
+
+#include <cxxopts.hpp>
+
+#include <polymesh/formats.hh>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+using namespace LayoutEmbedding;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+std::vector<std::string> split_list(const std::string& _s)
+{
+    std::vector<std::string> result;
+    std::istringstream ss(_s);
+    std::string token;
+    while (std::getline(ss, token, ',')) {
+        if (!token.empty()) {
+            result.push_back(token);
+        }
+    }
+    return result;
+}
+
+std::vector<int> parse_int_list(const std::string& _s, const std::string& _option)
+{
+    std::vector<int> result;
+    for (const auto& token : split_list(_s)) {
+        try {
+            result.push_back(std::stoi(token));
+        }
+        catch (...) {
+            throw cxxopts::OptionException("Invalid value for " + _option + ": " + _s);
+        }
+    }
+    if (result.empty()) {
+        throw cxxopts::OptionException("Empty list for " + _option);
+    }
+    return result;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    register_segfault_handler();
+
+    std::vector<SyntheticShape> shapes;
+    std::vector<int> target_sizes;
+    std::vector<int> layout_sizes;
+    std::vector<int> seeds;
+    int jitter_steps = 0;
+    std::string algo;
+    fs::path output_dir;
+
+    cxxopts::Options opts("generate_workload",
+        "Generates synthetic target meshes with layouts and landmarks.\n"
+        "Shapes: sphere, torus, bumpy, elongated.\n"
+        "\n"
+        "Output files are written to <build-folder>/output/generate_workload.\n"
+        "The generated manifest.txt can be passed to embed_batch.\n");
+    opts.add_options()("shape", "Comma-separated list of shapes.", cxxopts::value<std::string>()->default_value("sphere"));
+    opts.add_options()("n,target-vertices", "Comma-separated list of (approximate) target vertex counts.", cxxopts::value<std::string>()->default_value("10000"));
+    opts.add_options()("e,layout-edges", "Comma-separated list of (approximate) layout edge counts.", cxxopts::value<std::string>()->default_value("42"));
+    opts.add_options()("seed", "Comma-separated list of seeds.", cxxopts::value<std::string>()->default_value("0"));
+    opts.add_options()("jitter", "Number of random steps each landmark is moved away from the closest target vertex.", cxxopts::value<int>()->default_value("0"));
+    opts.add_options()("a,algo", "Algorithm written to the manifest.", cxxopts::value<std::string>()->default_value("bnb"));
+    opts.add_options()("o,output", "Output directory.", cxxopts::value<std::string>()->default_value((fs::path(LE_OUTPUT_PATH) / "generate_workload").string()));
+    opts.add_options()("h,help", "Help.");
+    try {
+        auto args = opts.parse(argc, argv);
+        if (args.count("help")) {
+            std::cout << opts.help() << std::endl;
+            return 0;
+        }
+
+        for (const auto& s : split_list(args["shape"].as<std::string>())) {
+            SyntheticShape shape;
+            if (!parse_synthetic_shape(s, shape)) {
+                throw cxxopts::OptionException("Unknown shape: " + s);
+            }
+            shapes.push_back(shape);
+        }
+        target_sizes = parse_int_list(args["target-vertices"].as<std::string>(), "target-vertices");
+        layout_sizes = parse_int_list(args["layout-edges"].as<std::string>(), "layout-edges");
+        seeds = parse_int_list(args["seed"].as<std::string>(), "seed");
+        jitter_steps = args["jitter"].as<int>();
+        algo = args["algo"].as<std::string>();
+        output_dir = args["output"].as<std::string>();
+
+        if (shapes.empty()) {
+            throw cxxopts::OptionException("No shape given");
+        }
+        for (const int n : target_sizes) {
+            if (n < 12) {
+                throw cxxopts::OptionException("Target meshes need at least 12 vertices");
+            }
+        }
+    }
+    catch (const cxxopts::OptionException& e) {
+        std::cout << e.what() << "\n\n";
+        std::cout << opts.help() << std::endl;
+        return 1;
+    }
+
+    fs::create_directories(output_dir);
+    std::ofstream manifest(output_dir / "manifest.txt");
+    if (!manifest.is_open()) {
+        LE_ERROR_THROW("Could not open " << output_dir / "manifest.txt");
+    }
+
+    for (const auto shape : shapes) {
+        for (const int n_target : target_sizes) {
+            for (const int n_layout : layout_sizes) {
+                for (const int seed : seeds) {
+                    SyntheticWorkloadSettings settings;
+                    settings.shape = shape;
+                    settings.target_vertices = n_target;
+                    settings.layout_edges = n_layout;
+                    settings.jitter_steps = jitter_steps;
+                    settings.seed = seed;
+
+                    Timer timer;
+                    EmbeddingInput input;
+                    make_synthetic_workload(input, settings);
+
+                    const std::string name = to_string(shape)
+                            + "_t" + std::to_string(input.t_m.vertices().size())
+                            + "_e" + std::to_string(input.l_m.edges().size())
+                            + "_s" + std::to_string(seed);
+                    const std::string target_file = name + "_target.obj";
+                    const std::string layout_file = name + "_layout.obj";
+                    const std::string landmarks_file = name + "_landmarks.txt";
+
+                    pm::save((output_dir / target_file).string(), input.t_pos);
+                    pm::save((output_dir / layout_file).string(), input.l_pos);
+                    std::ofstream landmarks(output_dir / landmarks_file);
+                    for (const auto l_v : input.l_m.vertices()) {
+                        landmarks << input.l_matching_vertex[l_v].idx.value << '\n';
+                    }
+
+                    manifest << "id=" << name << "_" << algo
+                             << " layout=" << layout_file
+                             << " target=" << target_file
+                             << " landmarks=" << landmarks_file
+                             << " landmark_format=id"
+                             << " algo=" << algo << '\n';
+
+                    std::cout << "Wrote " << name << " (" << timer.elapsed_seconds() << " s)" << std::endl;
+                }
+            }
+        }
+    }
+
+    std::cout << "Manifest: " << output_dir / "manifest.txt" << std::endl;
+
+    return 0;
+}
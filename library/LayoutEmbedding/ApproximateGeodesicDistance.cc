@@ -5,34 +5,95 @@
 
 #include <igl/heat_geodesics.h>
 
+#include <exception>
+
 namespace LayoutEmbedding {
 
-pm::vertex_attribute<double> approximate_geodesic_distance(const pm::vertex_attribute<tg::pos3>& _pos, const std::vector<pm::vertex_handle>& _source_vertices)
+GeodesicDistanceSolver::GeodesicDistanceSolver(const pm::vertex_attribute<tg::pos3>& _pos) :
+    m(&_pos.mesh()),
+    data(std::make_unique<igl::HeatGeodesicsData<double>>())
 {
     IGLMesh im = to_igl_mesh(_pos);
+    igl::heat_geodesics_precompute(im.V, im.F, *data);
+}
 
-    igl::HeatGeodesicsData<double> data;
-    igl::heat_geodesics_precompute(im.V, im.F, data);
+GeodesicDistanceSolver::~GeodesicDistanceSolver() = default;
 
+pm::vertex_attribute<double> GeodesicDistanceSolver::solve(const std::vector<pm::vertex_handle>& _source_vertices) const
+{
     // Build vector of source vertex indices
     Eigen::VectorXi gamma(_source_vertices.size());
     for (int row = 0; row < gamma.size(); ++row) {
         const auto& v = _source_vertices[row];
-        LE_ASSERT(v.mesh == &_pos.mesh());
+        LE_ASSERT(v.mesh == m);
         gamma[row] = v.idx.value;
     }
 
     Eigen::VectorXd D;
-    igl::heat_geodesics_solve(data, gamma, D);
+    igl::heat_geodesics_solve(*data, gamma, D);
 
-    const auto& m = _pos.mesh();
-    auto result = m.vertices().make_attribute<double>();
-    for (const auto& v : m.vertices()) {
+    auto result = m->vertices().make_attribute<double>();
+    for (const auto& v : m->vertices()) {
         result[v] = D[v.idx.value];
     }
     return result;
 }
 
+pm::vertex_attribute<double> GeodesicDistanceSolver::solve(const pm::vertex_handle& _source_vertex) const
+{
+    return solve(std::vector<pm::vertex_handle>{_source_vertex});
+}
+
+GeodesicDistanceMatrix GeodesicDistanceSolver::solve_each(const std::vector<pm::vertex_handle>& _source_vertices, const bool _parallel) const
+{
+    for (const auto& v : _source_vertices) {
+        LE_ASSERT(v.mesh == m);
+    }
+
+    GeodesicDistanceMatrix result;
+    result.num_sources = _source_vertices.size();
+    result.num_vertices = m->vertices().size();
+    result.data.resize((size_t)result.num_sources * result.num_vertices);
+
+    // Writes go to disjoint rows. Mesh attributes are not created here since that is not thread-safe.
+    std::vector<std::exception_ptr> errors(result.num_sources);
+    #pragma omp parallel for schedule(dynamic) if(_parallel)
+    for (int i = 0; i < result.num_sources; ++i) {
+        try {
+            Eigen::VectorXi gamma(1);
+            gamma[0] = _source_vertices[i].idx.value;
+            Eigen::VectorXd D;
+            igl::heat_geodesics_solve(*data, gamma, D);
+
+            double* row = result.data.data() + (size_t)i * result.num_vertices;
+            for (int j = 0; j < result.num_vertices; ++j) {
+                row[j] = D[j];
+            }
+        }
+        catch (...) {
+            errors[i] = std::current_exception();
+        }
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    return result;
+}
+
+const pm::Mesh& GeodesicDistanceSolver::mesh() const
+{
+    return *m;
+}
+
+pm::vertex_attribute<double> approximate_geodesic_distance(const pm::vertex_attribute<tg::pos3>& _pos, const std::vector<pm::vertex_handle>& _source_vertices)
+{
+    const GeodesicDistanceSolver solver(_pos);
+    return solver.solve(_source_vertices);
+}
+
 pm::vertex_attribute<double> approximate_geodesic_distance(const pm::vertex_attribute<tg::pos3>& _pos, const pm::vertex_handle& _source_vertex)
 {
     return approximate_geodesic_distance(_pos, std::vector<pm::vertex_handle>{_source_vertex});
@@ -3,8 +3,56 @@
 #include <polymesh/pm.hh>
 #include <typed-geometry/tg-lean.hh>
 
+#include <memory>
+#include <vector>
+
+namespace igl { template <typename Scalar> struct HeatGeodesicsData; }
+
 namespace LayoutEmbedding {
 
+/// Distances from a number of sources (rows) to all vertices of a mesh (columns, by vertex index).
+/// Stored row-major in a single flat array.
+struct GeodesicDistanceMatrix
+{
+    int num_sources = 0;
+    int num_vertices = 0;
+    std::vector<double> data;
+
+    double operator()(const int _source, const int _vertex) const { return data[(size_t)_source * num_vertices + _vertex]; }
+    double operator()(const int _source, const pm::vertex_handle& _v) const { return (*this)(_source, _v.idx.value); }
+
+    /// Pointer to the num_vertices distances from the given source.
+    const double* row(const int _source) const { return data.data() + (size_t)_source * num_vertices; }
+};
+
+/// Approximate geodesic distances via the heat method [Crane2013].
+/// The mesh is factorized once on construction, so any number of distance queries on the same mesh
+/// only cost a few back-substitutions each.
+/// The mesh (and positions) must not change during the lifetime of the solver.
+class GeodesicDistanceSolver
+{
+public:
+    explicit GeodesicDistanceSolver(const pm::vertex_attribute<tg::pos3>& _pos);
+    ~GeodesicDistanceSolver();
+
+    GeodesicDistanceSolver(const GeodesicDistanceSolver&) = delete;
+    GeodesicDistanceSolver& operator=(const GeodesicDistanceSolver&) = delete;
+
+    /// Distance to the closest of the source vertices.
+    pm::vertex_attribute<double> solve(const std::vector<pm::vertex_handle>& _source_vertices) const;
+    pm::vertex_attribute<double> solve(const pm::vertex_handle& _source_vertex) const;
+
+    /// Separate distance field for each of the source vertices (one row each).
+    /// The solves only read the shared factorization and are optionally distributed over threads.
+    GeodesicDistanceMatrix solve_each(const std::vector<pm::vertex_handle>& _source_vertices, const bool _parallel = true) const;
+
+    const pm::Mesh& mesh() const;
+
+private:
+    const pm::Mesh* m = nullptr;
+    std::unique_ptr<igl::HeatGeodesicsData<double>> data;
+};
+
 pm::vertex_attribute<double>
 approximate_geodesic_distance(
     const pm::vertex_attribute<tg::pos3>& _pos,
@@ -5,8 +5,8 @@
 #include <LayoutEmbedding/GetQueueContainer.hh>
 #include <LayoutEmbedding/Greedy.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
-
-#include <glow-extras/timing/CpuTimer.hh>
+#include <LayoutEmbedding/Util/Profiling.hh>
+#include <LayoutEmbedding/Util/Timer.hh>
 
 #include <chrono>
 #include <queue>
@@ -38,10 +38,17 @@ struct Candidate
 
 BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettings& _settings, const std::string& _name)
 {
-    glow::timing::CpuTimer timer;
+    Timer timer;
+    LE_PROFILE_ONLY(const Profile profile_before = thread_profile();)
+    LE_PROFILE_NAMED_SCOPE(bnb_scope, "branch_and_bound");
 
     BranchAndBoundResult result(_name, _settings);
 
+    // Build the search graph and face regions once. All embeddings below are copies of _em,
+    // which inherit both and patch them locally instead of rebuilding them per state.
+    _em.search_graph();
+    _em.face_regions();
+
     InsertionSequence best_insertion_sequence;
     double global_upper_bound = std::numeric_limits<double>::infinity();
 
@@ -61,6 +68,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
     // Run heuristic algorithm to find a tighter initial upper bound.
     if (_settings.use_greedy_init) {
+        LE_PROFILE_SCOPE("greedy_init");
         Embedding em(_em);
         const auto results = embed_competitors(em);
         global_upper_bound = em.total_embedded_path_length();
@@ -68,7 +76,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
         if (_settings.record_upper_bound_events) {
             BranchAndBoundResult::UpperBoundEvent event;
-            event.t = timer.elapsedSecondsD();
+            event.t = timer.elapsed_seconds();
             event.upper_bound = global_upper_bound;
             result.upper_bound_events.push_back(event);
         }
@@ -76,6 +84,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
     std::map<HashValue, State> known_states;
     {
+        LE_PROFILE_SCOPE("root_state");
         EmbeddingState es(_em, _settings);
         es.compute_all_candidate_paths();
         es.detect_candidate_path_conflicts();
@@ -100,11 +109,17 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
 
     int iter = 0;
     while (!q.empty()) {
+        // Iteration limit
+        if (_settings.max_iterations > 0 && iter >= _settings.max_iterations) {
+            std::cout << "Reached iteration limit of " << _settings.max_iterations << ". Terminating." << std::endl;
+            break;
+        }
+
         ++iter;
 
         // Time limit
         if (_settings.time_limit > 0.0) {
-            if (timer.elapsedSecondsD() >= _settings.time_limit) {
+            if (timer.elapsed_seconds() >= _settings.time_limit) {
                 std::cout << "Reached time limit of " << _settings.time_limit << " s. Terminating." << std::endl;
                 if (std::isinf(global_upper_bound)) {
                     std::cout << "Warning: No valid solution was found within that time." << std::endl;
@@ -137,6 +152,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
         std::reverse(inserted_paths.begin(), inserted_paths.end());
 
         // Reconstruct the embedding associated with this state
+        LE_PROFILE_NAMED_SCOPE(reconstruct_scope, "reconstruct_state");
         EmbeddingState es(_em, _settings);
         LE_ASSERT_EQ(insertion_sequence.size(), inserted_paths.size());
         for (size_t i = 0; i < insertion_sequence.size(); ++i) {
@@ -146,6 +162,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
         }
 
         LE_ASSERT_EQ(es.hash(), c.state_hash);
+        LE_PROFILE_STOP(reconstruct_scope);
 
         // Reconstruct candidate paths
         auto& state = known_states[c.state_hash];
@@ -173,7 +190,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
         const auto& es_conflicting_edges = es.conflicting_edges();
         const auto& es_non_conflicting_edges = es.non_conflicting_edges();
 
-        std::cout << "t: " << timer.elapsedSecondsD();
+        std::cout << "t: " << timer.elapsed_seconds();
         std::cout << "    ";
         std::cout << "global UB: " << global_upper_bound;
         std::cout << "    ";
@@ -211,7 +228,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                 const auto& last_lower_bound = result.lower_bound_events.back();
                 if (min_lower_bound > last_lower_bound.lower_bound) { // Don't save redundant lower bound updates
                     BranchAndBoundResult::LowerBoundEvent event;
-                    event.t = timer.elapsedSecondsD();
+                    event.t = timer.elapsed_seconds();
                     event.lower_bound = min_lower_bound;
                     result.lower_bound_events.push_back(event);
                 }
@@ -282,19 +299,22 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                 std::cout << "New upper bound: " << global_upper_bound << std::endl;
                 if (_settings.record_upper_bound_events) {
                     BranchAndBoundResult::UpperBoundEvent event;
-                    event.t = timer.elapsedSecondsD();
+                    event.t = timer.elapsed_seconds();
                     event.upper_bound = global_upper_bound;
                     result.upper_bound_events.push_back(event);
                 }
             }
             else {
                 // Add children to the queue
+                LE_PROFILE_SCOPE("expand");
                 for (const auto& l_e : insertion_options) {
                     if (es.candidate_paths[l_e].empty()) {
                         continue;
                     }
 
+                    LE_PROFILE_NAMED_SCOPE(copy_scope, "state_copy");
                     EmbeddingState new_es(es); // Copy
+                    LE_PROFILE_STOP(copy_scope);
 
                     // Update new state by adding the new child halfedge
                     new_es.extend(l_e, es.candidate_paths[l_e]);
@@ -305,6 +325,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                     // TODO: re-enable? remove?
                     //if (_settings.use_state_hashing) {
                     if (known_states.count(new_es_hash)) {
+                        LE_PROFILE_COUNT("known_state_hits", 1);
                         continue;
                     }
                     //}
@@ -318,6 +339,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                     const double new_lower_bound = new_es.cost_lower_bound();
                     const double new_gap = 1.0 - new_lower_bound / global_upper_bound;
                     if (new_gap < _settings.optimality_gap) {
+                        LE_PROFILE_COUNT("pruned_states", 1);
                         continue;
                     }
 
@@ -350,6 +372,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
                         LE_ASSERT(false);
                     }
                     q.push(new_c);
+                    LE_PROFILE_COUNT("new_states", 1);
                 }
             }
         }
@@ -385,6 +408,7 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
     else {
         // Apply the victorious embedding sequence to the input embedding
         // Edges with predefined insertion sequence
+        LE_PROFILE_SCOPE("embed_result");
         std::set<pm::edge_index> l_e_embedded;
         result.insertion_sequence.clear();
         for (const auto& l_ei : best_insertion_sequence) {
@@ -408,6 +432,9 @@ BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettin
         result.cost = _em.total_embedded_path_length();
     }
 
+    LE_PROFILE_STOP(bnb_scope);
+    LE_PROFILE_ONLY(result.profile = thread_profile() - profile_before;)
+
     return result;
 }
 
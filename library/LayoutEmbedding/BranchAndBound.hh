@@ -2,6 +2,7 @@
 
 #include <LayoutEmbedding/Embedding.hh>
 #include <LayoutEmbedding/InsertionSequence.hh>
+#include <LayoutEmbedding/Util/Profiling.hh>
 
 namespace LayoutEmbedding {
 
@@ -9,6 +10,7 @@ struct BranchAndBoundSettings
 {
     double optimality_gap = 0.01;
     double time_limit = 1 * 60 * 60; // Seconds. Set to <= 0 to disable.
+    int max_iterations = 0; // Set to <= 0 to disable.
 
     bool record_upper_bound_events = true;
     bool record_lower_bound_events = false;
@@ -64,6 +66,8 @@ struct BranchAndBoundResult
 
     double max_state_tree_memory_estimate = 0.0; // Bytes
     int num_iters = 0;
+
+    Profile profile; // Per-phase breakdown. Empty unless built with LE_ENABLE_PROFILING.
 };
 
 BranchAndBoundResult branch_and_bound(Embedding& _em, const BranchAndBoundSettings& _settings = BranchAndBoundSettings(), const std::string& _name = "bnb");
@@ -1,12 +1,19 @@
 ﻿#include "Embedding.hh"
 
 #include <LayoutEmbedding/Connectivity.hh>
+#include <LayoutEmbedding/MeshIO.hh>
 #include <LayoutEmbedding/VertexRepulsiveEnergy.hh>
 #include <LayoutEmbedding/VirtualVertexAttribute.hh>
 #include <LayoutEmbedding/Snake.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/MappedFile.hh>
+#include <LayoutEmbedding/Util/Profiling.hh>
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <queue>
+#include <set>
 
 namespace LayoutEmbedding {
 
@@ -15,8 +22,8 @@ Embedding::Embedding(EmbeddingInput& _input) :
     t_m(),
     t_pos(t_m),
     l_matching_vertex(layout_mesh()),
-    t_matching_vertex(target_mesh()),
-    t_matching_halfedge(target_mesh())
+    t_matching_vertex(t_m),
+    t_matching_halfedge(t_m)
 {
     t_m.copy_from(_input.t_m);
     t_pos.copy_from(_input.t_pos);
@@ -62,10 +69,12 @@ Embedding& Embedding::operator=(const Embedding& _em)
         t_matching_halfedge[t_he] = layout_mesh()[_em.t_matching_halfedge[t_he.idx].idx];
     }
 
-    if (_em.vertex_repulsive_energy.has_value()) {
-        vertex_repulsive_energy = target_mesh().vertices().make_attribute<Eigen::VectorXd>();
-        vertex_repulsive_energy->copy_from(*_em.vertex_repulsive_energy);
-    }
+    // Shares the solved fields, copies the (small) table of split vertices.
+    vertex_repulsive_energy = _em.vertex_repulsive_energy;
+
+    // Element indices are preserved by copy_from, so the snapshot stays valid.
+    search_graph_cache = _em.search_graph_cache;
+    face_regions_cache = _em.face_regions_cache;
 
     return *this;
 }
@@ -266,24 +275,147 @@ tg::pos3 Embedding::element_pos(const VirtualVertex& _t_vv) const
     }
 }
 
-VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector_start, const pm::halfedge_handle& _t_h_sector_end, ShortestPathMetric _metric) const
+namespace
+{
+
+struct Distance
 {
-    struct Distance
+    int edges_crossed = std::numeric_limits<int>::max();
+    double distance_from_source = std::numeric_limits<double>::infinity();
+    double remaining_distance_heuristic = 0.0; // Used for A* search
+
+    bool operator<(const Distance& rhs) const
     {
-        int edges_crossed = std::numeric_limits<int>::max();
-        double distance_from_source = std::numeric_limits<double>::infinity();
-        double remaining_distance_heuristic = 0.0; // Used for A* search
+        return distance_from_source + remaining_distance_heuristic < rhs.distance_from_source + rhs.remaining_distance_heuristic;
+    }
+};
 
-        bool operator<(const Distance& rhs) const
-        {
-            return distance_from_source + remaining_distance_heuristic < rhs.distance_from_source + rhs.remaining_distance_heuristic;
+/// Per-node state of Embedding::find_shortest_path_kernel, shared by all metrics and reused across calls (one per thread).
+/// Values are only valid if their stamp matches the current one,
+/// so the cost of a search only depends on the number of nodes it visits, not on the size of the mesh.
+struct SearchWorkspace
+{
+    std::vector<Distance> distance;
+    std::vector<int> prev;
+    std::vector<unsigned int> stamp;
+    unsigned int current_stamp = 0;
+
+    void begin(const int _num_nodes)
+    {
+        if ((int)stamp.size() < _num_nodes) {
+            distance.resize(_num_nodes);
+            prev.resize(_num_nodes);
+            stamp.resize(_num_nodes, 0);
         }
-    };
+        else if ((int)stamp.size() > 4 * _num_nodes) {
+            // Release the memory of a much larger graph searched before
+            distance.resize(_num_nodes);
+            prev.resize(_num_nodes);
+            stamp.resize(_num_nodes);
+            distance.shrink_to_fit();
+            prev.shrink_to_fit();
+            stamp.shrink_to_fit();
+        }
+        if (++current_stamp == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            current_stamp = 1;
+        }
+    }
+
+    Distance& distance_at(const int _i)
+    {
+        if (stamp[_i] != current_stamp) {
+            stamp[_i] = current_stamp;
+            distance[_i] = Distance();
+            prev[_i] = -1;
+        }
+        return distance[_i];
+    }
+};
+
+SearchWorkspace& search_workspace()
+{
+    thread_local SearchWorkspace ws;
+    return ws;
+}
+
+/// Metric policies for Embedding::find_shortest_path_kernel.
+/// Nodes and arcs are indices into the SearchGraph of the Embedding.
+
+struct GeodesicMetric
+{
+    const SearchGraph& g;
+    tg::pos3 p_end;
+
+    double distance(const double _dist_from, const int /*_i_from*/, const int _arc, const int /*_i_to*/) const
+    {
+        return _dist_from + g.arc_length[_arc];
+    }
+
+    double heuristic(const int _i_to) const
+    {
+        return tg::distance(g.node_pos[_i_to], p_end);
+    }
+};
+
+/// [Praun2001]: The cost of reaching a node only depends on the node itself.
+struct VertexRepulsiveMetric
+{
+    const pm::Mesh& t_m;
+    VertexRepulsiveEnergy::Field energy_start;
+    VertexRepulsiveEnergy::Field energy_end;
+
+    static double energy_at(const pm::Mesh& _t_m, const VertexRepulsiveEnergy::Field& _energy, const VirtualVertex& _t_vv)
+    {
+        if (is_real_vertex(_t_vv)) {
+            return _energy[pm::vertex_index(_t_vv.element_index())];
+        }
+        else {
+            // Vertex on an edge, average of the endpoints
+            const auto t_e = _t_m[pm::edge_index(_t_vv.element_index())];
+            return tg::mix(_energy[t_e.vertexA()], _energy[t_e.vertexB()], 0.5);
+        }
+    }
+
+    double distance(const double /*_dist_from*/, const int /*_i_from*/, const int /*_arc*/, const int _i_to) const
+    {
+        const auto vv = VirtualVertex::from_unified_index(_i_to);
+        return 1.0 - energy_at(t_m, energy_start, vv) - energy_at(t_m, energy_end, vv);
+    }
+
+    double heuristic(const int /*_i_to*/) const
+    {
+        return 0.0; // No heuristic
+    }
+};
+
+/// User-supplied non-negative weights per virtual vertex, scaling the arc lengths.
+struct WeightedMetric
+{
+    const SearchGraph& g;
+    const VirtualVertexAttribute<double>& weights;
+    tg::pos3 p_end;
+    double min_weight; // Keeps the A* heuristic admissible
+
+    double distance(const double _dist_from, const int _i_from, const int _arc, const int _i_to) const
+    {
+        return _dist_from + g.arc_length[_arc] * 0.5 * (weights.data[_i_from] + weights.data[_i_to]);
+    }
 
+    double heuristic(const int _i_to) const
+    {
+        return min_weight * tg::distance(g.node_pos[_i_to], p_end);
+    }
+};
+
+}
+
+template <typename Metric>
+VirtualPath Embedding::find_shortest_path_kernel(const pm::halfedge_handle& _t_h_sector_start, const pm::halfedge_handle& _t_h_sector_end, const Metric& _metric) const
+{
     struct Candidate
     {
         VirtualVertex vv;
-        tg::pos3 p;
         Distance dist;
 
         bool operator>(const Candidate& rhs) const
@@ -292,19 +424,18 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
         }
     };
 
+    LE_PROFILE_SCOPE("find_shortest_path");
     LE_ASSERT(_t_h_sector_start.mesh == &target_mesh());
     LE_ASSERT(_t_h_sector_end.mesh == &target_mesh());
 
-    VirtualVertexAttribute<VirtualVertex> prev(target_mesh());
-    VirtualVertexAttribute<Distance> distance(target_mesh());
-
     const pm::vertex_handle t_v_start = _t_h_sector_start.vertex_from();
     const pm::vertex_handle t_v_end   = _t_h_sector_end.vertex_from();
 
     const VirtualVertex vv_start(t_v_start);
     const VirtualVertex vv_end(t_v_end);
 
-    auto get_virtual_vertices_in_sector = [&](const pm::halfedge_handle& t_he_sector) {
+    // Also returns a target face inside the sector
+    auto get_virtual_vertices_in_sector = [&](const pm::halfedge_handle& t_he_sector, pm::face_handle& t_f_sector) {
         auto t_he_sector_start = t_he_sector;
         auto t_he_sector_end = t_he_sector;
         t_he_sector_end = t_he_sector_end.prev().opposite(); // Rotate ccw
@@ -323,6 +454,7 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
             }
         }
         std::vector<VirtualVertex> vvs;
+        t_f_sector = t_he_sector_start.face();
         auto t_he = t_he_sector_start;
         do {
             // Incident edge midpoints
@@ -339,38 +471,63 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
         return vvs;
     };
 
-    std::vector<VirtualVertex> legal_first_vvs = get_virtual_vertices_in_sector(_t_h_sector_start);
-    std::vector<VirtualVertex> legal_last_vvs = get_virtual_vertices_in_sector(_t_h_sector_end);
+    pm::face_handle t_f_sector_start;
+    pm::face_handle t_f_sector_end;
+    std::vector<VirtualVertex> legal_first_vvs = get_virtual_vertices_in_sector(_t_h_sector_start, t_f_sector_start);
+    std::vector<VirtualVertex> legal_last_vvs = get_virtual_vertices_in_sector(_t_h_sector_end, t_f_sector_end);
+
+    // Embedded paths cannot be crossed, so the search never leaves the region containing the start sector.
+    // If the end sector lies in a different region, there is no path.
+    if (t_f_sector_start.is_valid() && t_f_sector_end.is_valid()) {
+        const auto& regions = face_regions();
+        if (regions.region(t_f_sector_start) != regions.region(t_f_sector_end)) {
+            LE_PROFILE_COUNT("different_regions", 1);
+            return {};
+        }
+    }
+
+    const SearchGraph& g = search_graph();
 
-    distance[t_v_start].edges_crossed = 0;
-    distance[t_v_start].distance_from_source = 0.0;
+    auto& ws = search_workspace();
+    ws.begin(g.num_nodes());
+    auto node_distance = [&](const int i) -> Distance& {
+        return ws.distance_at(i);
+    };
+    auto& prev = ws.prev;
+
+    node_distance(vv_start.unified_index()).edges_crossed = 0;
+    node_distance(vv_start.unified_index()).distance_from_source = 0.0;
 
     std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> q;
 
     {
         Candidate c;
-        c.vv = VirtualVertex(t_v_start);
-        c.p = t_pos[t_v_start];
+        c.vv = vv_start;
         c.dist.edges_crossed = 0;
         c.dist.distance_from_source = 0.0;
         c.dist.remaining_distance_heuristic = std::numeric_limits<double>::max();
         q.push(c);
     }
 
-    auto legal_step = [&](const VirtualVertex& from, const VirtualVertex& to) {
-        if (from == vv_start) {
+    const int i_start = vv_start.unified_index();
+    const int i_end = vv_end.unified_index();
+
+    auto legal_step = [&](const int i_from, const int i_to) {
+        if (i_from == i_start) {
+            const auto to = VirtualVertex::from_unified_index(i_to);
             if (std::find(legal_first_vvs.cbegin(), legal_first_vvs.cend(), to) == legal_first_vvs.cend()) {
                 return false;
             }
         }
 
-        if (to == vv_end) {
+        if (i_to == i_end) {
+            const auto from = VirtualVertex::from_unified_index(i_from);
             if (std::find(legal_last_vvs.cbegin(), legal_last_vvs.cend(), from) == legal_last_vvs.cend()) {
                 return false;
             }
         }
         else {
-            if (is_blocked(to)) {
+            if (g.node_blocked[i_to]) {
                 return false;
             }
         }
@@ -378,115 +535,65 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
         return true;
     };
 
-    auto visit_vv = [&](const Candidate& c, const VirtualVertex& vv) {
-        if (legal_step(c.vv, vv)) {
-            const Distance& current_dist = distance[vv];
-            const auto& p = element_pos(vv);
-            Distance new_dist = c.dist;
+    LE_PROFILE_ONLY(int64_t num_settled = 0;)
+    LE_PROFILE_ONLY(int64_t num_pushes = 1;)
+    while (!q.empty()) {
+        const auto u = q.top();
+        q.pop();
 
-            if (_metric == ShortestPathMetric::Geodesic) {
-                new_dist.distance_from_source += tg::distance(c.p, p);
-                new_dist.remaining_distance_heuristic = tg::distance(p, t_pos[t_v_end]);
-            }
-            else if (_metric == ShortestPathMetric::VertexRepulsive) {
-                const auto& l_v_start = matching_layout_vertex(t_v_start);
-                const auto& l_v_end   = matching_layout_vertex(t_v_end);
-                LE_ASSERT(l_v_start.is_valid());
-                LE_ASSERT(l_v_end.is_valid());
-                const double vrf_start = get_vertex_repulsive_energy(vv, l_v_start);
-                const double vrf_end   = get_vertex_repulsive_energy(vv, l_v_end);
-                new_dist.distance_from_source = 1.0 - vrf_start - vrf_end;
-                new_dist.remaining_distance_heuristic = 0.0; // No heuristic
-            }
-            else {
-                LE_ASSERT(false); // Never reached.
+        const int i_u = u.vv.unified_index();
+        if (i_u == i_end) {
+            break;
+        }
+
+        // Skip outdated queue entries. Expanding them cannot improve any distance.
+        if (u.dist.distance_from_source > node_distance(i_u).distance_from_source) {
+            continue;
+        }
+        LE_PROFILE_ONLY(++num_settled;)
+
+        // Expand neighborhood (vertices and edge midpoints)
+        const auto& arcs = g.node_arcs[i_u];
+        for (int a = arcs.begin; a < arcs.end; ++a) {
+            const int i_v = g.arc_head[a];
+            if (!legal_step(i_u, i_v)) {
+                continue;
             }
 
-            if (is_real_edge(vv)) {
+            const auto vv = VirtualVertex::from_unified_index(i_v);
+            Distance new_dist = u.dist;
+            new_dist.distance_from_source = _metric.distance(u.dist.distance_from_source, i_u, a, i_v);
+            new_dist.remaining_distance_heuristic = _metric.heuristic(i_v);
+
+            if (vv.tag_is_edge()) {
                 new_dist.edges_crossed += 1;
             }
 
-            if (new_dist < current_dist) {
+            if (new_dist < node_distance(i_v)) {
                 Candidate new_c;
                 new_c.vv = vv;
-                new_c.p = p;
                 new_c.dist = new_dist;
 
-                distance[vv] = new_c.dist;
-                prev[vv] = c.vv;
+                node_distance(i_v) = new_c.dist;
+                prev[i_v] = i_u;
 
                 q.push(new_c);
-            }
-        }
-    };
-
-    while (!q.empty()) {
-        const auto u = q.top();
-        q.pop();
-
-        const auto& vv = u.vv;
-
-        // Expand vertex neighborhood
-        if (is_real_vertex(vv)) {
-            const auto& t_v = real_vertex(u.vv, target_mesh());
-
-            if (t_v == t_v_end) {
-                break;
-            }
-
-            // Add incident vertices (if they're not blocked)
-            for (const auto t_v_adj : t_v.adjacent_vertices()) {
-                visit_vv(u, VirtualVertex(t_v_adj));
-            }
-
-            // Add incident edge midpoints (if they're not blocked)
-            for (const auto t_he_out : t_v.outgoing_halfedges()) {
-                if (t_he_out.is_boundary()) {
-                    continue;
-                }
-                const auto eh_opp_edge = t_he_out.next().edge();
-                visit_vv(u, VirtualVertex(eh_opp_edge));
-            }
-        }
-        // Expand edge midpoint neighborhood
-        else if (is_real_edge(vv)) {
-            const auto& t_e = real_edge(vv, target_mesh());
-
-            const auto& t_he = t_e.halfedgeA();
-            const auto& t_he_opp = t_e.halfedgeB();
-
-            // Visit opposite vertices
-            const auto& t_v_u = opposite_vertex(t_he);
-            const auto& t_v_u_opp = opposite_vertex(t_he_opp);
-            visit_vv(u, VirtualVertex(t_v_u));
-            visit_vv(u, VirtualVertex(t_v_u_opp));
-
-            // Visit incident edges
-            if (!t_he.is_boundary()) {
-                const auto& eh_u_r = t_he.next().edge();
-                const auto& eh_u_l = t_he.prev().edge();
-                visit_vv(u, eh_u_r);
-                visit_vv(u, eh_u_l);
-            }
-            if (!t_he_opp.is_boundary()) {
-                const auto& eh_u_opp_r = t_he_opp.prev().edge();
-                const auto& eh_u_opp_l = t_he_opp.next().edge();
-                visit_vv(u, eh_u_opp_r);
-                visit_vv(u, eh_u_opp_l);
+                LE_PROFILE_ONLY(++num_pushes;)
             }
         }
     }
+    LE_PROFILE_COUNT("settled_nodes", num_settled);
+    LE_PROFILE_COUNT("heap_pushes", num_pushes);
 
-    if (std::isinf(distance[t_v_end].distance_from_source)) {
+    if (std::isinf(node_distance(i_end).distance_from_source)) {
         return {};
     }
     else {
         VirtualPath path;
-        VirtualVertex vv_current(t_v_end);
-        VirtualVertex vv_start(t_v_start);
-        while (vv_current != vv_start) {
-            path.push_back(vv_current);
-            vv_current = prev[vv_current];
+        int i_current = i_end;
+        while (i_current != i_start) {
+            path.push_back(VirtualVertex::from_unified_index(i_current));
+            i_current = prev[i_current];
         }
         path.push_back(vv_start);
         std::reverse(path.begin(), path.end());
@@ -494,6 +601,49 @@ VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector
     }
 }
 
+VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector_start, const pm::halfedge_handle& _t_h_sector_end, ShortestPathMetric _metric) const
+{
+    LE_ASSERT(_t_h_sector_start.mesh == &target_mesh());
+    LE_ASSERT(_t_h_sector_end.mesh == &target_mesh());
+
+    // Dispatch once per call. Each metric gets its own specialized kernel.
+    if (_metric == ShortestPathMetric::Geodesic) {
+        const GeodesicMetric metric{search_graph(), t_pos[_t_h_sector_end.vertex_from()]};
+        return find_shortest_path_kernel(_t_h_sector_start, _t_h_sector_end, metric);
+    }
+    else if (_metric == ShortestPathMetric::VertexRepulsive) {
+        const auto& l_v_start = matching_layout_vertex(_t_h_sector_start.vertex_from());
+        const auto& l_v_end   = matching_layout_vertex(_t_h_sector_end.vertex_from());
+        LE_ASSERT(l_v_start.is_valid());
+        LE_ASSERT(l_v_end.is_valid());
+        const auto& fields = vertex_repulsive_energy_fields();
+        const VertexRepulsiveMetric metric{t_m, fields.field(l_v_start), fields.field(l_v_end)};
+        return find_shortest_path_kernel(_t_h_sector_start, _t_h_sector_end, metric);
+    }
+    else {
+        LE_ERROR_THROW("Unknown ShortestPathMetric.");
+    }
+}
+
+VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _t_h_sector_start, const pm::halfedge_handle& _t_h_sector_end, const VirtualVertexAttribute<double>& _weights) const
+{
+    LE_ASSERT(_t_h_sector_start.mesh == &target_mesh());
+    LE_ASSERT(_t_h_sector_end.mesh == &target_mesh());
+    LE_ASSERT_GEQ((int)_weights.data.size(), virtual_vertex_index_bound(t_m));
+
+    double min_weight = std::numeric_limits<double>::infinity();
+    for (const auto t_v : t_m.vertices()) {
+        min_weight = std::min(min_weight, _weights[t_v]);
+    }
+    for (const auto t_e : t_m.edges()) {
+        min_weight = std::min(min_weight, _weights[t_e]);
+    }
+    LE_ASSERT_GEQ(min_weight, 0.0);
+
+    const WeightedMetric metric{search_graph(), _weights, t_pos[_t_h_sector_end.vertex_from()], min_weight};
+    return find_shortest_path_kernel(_t_h_sector_start, _t_h_sector_end, metric);
+}
+
 VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _l_he, ShortestPathMetric _metric) const
 {
     LE_ASSERT(_l_he.mesh == &layout_mesh());
@@ -511,6 +661,15 @@ VirtualPath Embedding::find_shortest_path(const pm::edge_handle& _l_e, ShortestP
     return find_shortest_path(l_he, _metric);
 }
 
+VirtualPath Embedding::find_shortest_path(const pm::halfedge_handle& _l_he, const VirtualVertexAttribute<double>& _weights) const
+{
+    LE_ASSERT(_l_he.mesh == &layout_mesh());
+    LE_ASSERT(!is_embedded(_l_he));
+    const auto t_he_sector_start = get_embeddable_sector(_l_he);
+    const auto t_he_sector_end = get_embeddable_sector(_l_he.opposite());
+    return find_shortest_path(t_he_sector_start, t_he_sector_end, _weights);
+}
+
 double Embedding::path_length(const VirtualPath& _path) const
 {
     LE_ASSERT_GEQ(_path.size(), 2);
@@ -527,14 +686,17 @@ double Embedding::path_length(const VirtualPath& _path) const
 
 void Embedding::embed_path(const pm::halfedge_handle& _l_he, const VirtualPath& _path)
 {
+    LE_PROFILE_SCOPE("embed_path");
     LE_ASSERT(!get_embedded_target_halfedge(_l_he).is_valid());
     LE_ASSERT_GEQ(_path.size(), 2);
 
     // Turn the VertexEdgePath into a pure vertex path by splitting edges
+    const int num_t_f_before = t_m.all_faces().size();
     std::vector<pm::vertex_handle> vertex_path;
+    std::vector<pm::vertex_handle> t_v_new_all;
     for (const auto& vv : _path) {
         if (is_real_edge(vv)) {
-            const auto& t_e = real_edge(vv, target_mesh());
+            const auto& t_e = real_edge(vv, t_m);
             const auto& t_vA = t_e.vertexA();
             const auto& t_vB = t_e.vertexB();
 
@@ -542,40 +704,70 @@ void Embedding::embed_path(const pm::halfedge_handle& _l_he, const VirtualPath&
             const auto& p1 = t_pos[t_vB];
             const auto p = tg::mix(p0, p1, 0.5);
 
-            const auto t_v_new = target_mesh().edges().split_and_triangulate(t_e);
+            const auto t_v_new = t_m.edges().split_and_triangulate(t_e);
             t_pos[t_v_new] = p;
 
             if (vertex_repulsive_energy.has_value()) {
-                Eigen::VectorXd vre = 0.5 * (*vertex_repulsive_energy)[t_vA] + 0.5 * (*vertex_repulsive_energy)[t_vB];
-                (*vertex_repulsive_energy)[t_v_new] = vre;
+                vertex_repulsive_energy->add_interpolated_vertex(t_v_new, t_vA, t_vB, 0.5);
             }
 
             vertex_path.push_back(t_v_new);
+            t_v_new_all.push_back(t_v_new);
         }
         else {
-            vertex_path.push_back(real_vertex(vv, target_mesh()));
+            vertex_path.push_back(real_vertex(vv, t_m));
         }
     }
+    LE_PROFILE_COUNT("edge_splits", t_v_new_all.size());
 
     // Mark the halfedges along the newly subdivided vertex path
     for (int i = 0; i < vertex_path.size() - 1; ++i) {
         int j = i + 1;
         const auto t_he = pm::halfedge_from_to(vertex_path[i], vertex_path[j]);
         LE_ASSERT(t_he.is_valid());
-        LE_ASSERT(matching_layout_halfedge(t_he).is_invalid());
-        LE_ASSERT(matching_layout_halfedge(t_he.opposite()).is_invalid());
+        LE_ASSERT(t_matching_halfedge[t_he].is_invalid());
+        LE_ASSERT(t_matching_halfedge[t_he.opposite()].is_invalid());
         t_matching_halfedge[t_he] = _l_he;
         t_matching_halfedge[t_he.opposite()] = _l_he.opposite();
     }
+
+    update_search_graph(t_v_new_all, vertex_path);
+    if (face_regions_cache.has_value()) {
+        face_regions_cache->update_after_embed(*this, num_t_f_before, vertex_path);
+    }
 }
 
 void Embedding::embed_path(const pm::halfedge_handle& _l_he, const Snake& _snake)
 {
+    LE_PROFILE_SCOPE("embed_snake");
     LE_ASSERT(!get_embedded_target_halfedge(_l_he).is_valid());
     LE_ASSERT_GEQ(_snake.vertices.size(), 2);
 
+    // Endpoints of the edges that are going to be split by the snake
+    std::vector<std::pair<pm::vertex_handle, pm::vertex_handle>> t_split_edges;
+    for (int i = 1; i < (int)_snake.vertices.size() - 1; ++i) {
+        const auto& sv = _snake.vertices[i];
+        t_split_edges.push_back({sv.h.vertex_from(), sv.h.vertex_to()});
+    }
+
     // Turn the Snake into a pure vertex path by splitting edges
+    const int num_t_v_before = t_m.all_vertices().size();
+    const int num_t_f_before = t_m.all_faces().size();
     const auto vertex_path = embed_snake(_snake, t_m, t_pos);
+    std::vector<pm::vertex_handle> t_v_new_all;
+    for (const auto& t_v : vertex_path) {
+        if (t_v.idx.value >= num_t_v_before) {
+            t_v_new_all.push_back(t_v);
+        }
+    }
+    LE_PROFILE_COUNT("edge_splits", t_v_new_all.size());
+
+    if (vertex_repulsive_energy.has_value()) {
+        for (int i = 1; i < (int)vertex_path.size() - 1; ++i) {
+            const auto& [t_v_a, t_v_b] = t_split_edges[i - 1];
+            vertex_repulsive_energy->add_interpolated_vertex(vertex_path[i], t_v_a, t_v_b, _snake.vertices[i].lambda);
+        }
+    }
     LE_ASSERT(matching_layout_vertex(vertex_path.front()).is_valid());
     LE_ASSERT(matching_layout_vertex(vertex_path.back()).is_valid());
     LE_ASSERT(matching_layout_vertex(vertex_path.front()) == _l_he.vertex_from());
@@ -586,11 +778,16 @@ void Embedding::embed_path(const pm::halfedge_handle& _l_he, const Snake& _snake
         int j = i + 1;
         const auto t_he = pm::halfedge_from_to(vertex_path[i], vertex_path[j]);
         LE_ASSERT(t_he.is_valid());
-        LE_ASSERT(matching_layout_halfedge(t_he).is_invalid());
-        LE_ASSERT(matching_layout_halfedge(t_he.opposite()).is_invalid());
+        LE_ASSERT(t_matching_halfedge[t_he].is_invalid());
+        LE_ASSERT(t_matching_halfedge[t_he.opposite()].is_invalid());
         t_matching_halfedge[t_he] = _l_he;
         t_matching_halfedge[t_he.opposite()] = _l_he.opposite();
     }
+
+    update_search_graph(t_v_new_all, vertex_path);
+    if (face_regions_cache.has_value()) {
+        face_regions_cache->update_after_embed(*this, num_t_f_before, vertex_path);
+    }
 }
 
 void Embedding::unembed_path(const pm::halfedge_handle& _l_he)
@@ -606,6 +803,11 @@ void Embedding::unembed_path(const pm::halfedge_handle& _l_he)
         t_matching_halfedge[t_he.opposite()] = pm::halfedge_handle::invalid;
     }
     LE_ASSERT(!is_embedded(_l_he));
+
+    update_search_graph({}, path);
+    if (face_regions_cache.has_value()) {
+        face_regions_cache->update_after_unembed(*this, path);
+    }
 }
 
 void Embedding::unembed_path(const pm::edge_handle& _l_e)
@@ -643,35 +845,21 @@ std::vector<pm::vertex_handle> Embedding::get_embedded_path(const pm::halfedge_h
 
 std::vector<pm::face_handle> Embedding::get_patch(const pm::face_handle& _l_f) const
 {
-    // Collect faces inside patch via flood fill
-    std::vector<pm::face_handle> patch;
-    std::queue<pm::halfedge_handle> queue;
-    queue.push(get_embedded_target_halfedge(_l_f.any_halfedge()));
-
-    auto visited = t_m.faces().make_attribute<bool>(false);
-    while (!queue.empty()) {
-        const auto t_h = queue.front();
-        LE_ASSERT(t_h.is_valid());
-        const auto t_f = t_h.face();
-        queue.pop();
-
-        // Already visited?
-        if (visited[t_f])
-            continue;
-        visited[t_f] = true;
-
-        // Add face to patch
-        patch.push_back(t_f);
-
-        // Enqueue neighbors (if not visited and not blocked)
-        for (auto t_h_inside : t_f.halfedges()) {
-            const auto t_h_outside = t_h_inside.opposite();
-            if (!visited[t_h_outside.face()] && !is_blocked(t_h_outside.edge()))
-                queue.push(t_h_outside);
+    LE_ASSERT(_l_f.mesh == &layout_mesh());
+    for (const auto l_h : _l_f.halfedges()) {
+        const auto t_h = get_embedded_target_halfedge(l_h);
+        if (t_h.is_valid()) {
+            return get_region(t_h);
         }
     }
+    LE_ERROR_THROW("No halfedge of the layout face is embedded.");
+}
 
-    return patch;
+std::vector<pm::face_handle> Embedding::get_region(const pm::halfedge_handle& _t_h) const
+{
+    LE_ASSERT(_t_h.mesh == &t_m);
+    const auto& regions = face_regions();
+    return regions.faces(t_m, regions.region(_t_h.face()));
 }
 
 double Embedding::embedded_path_length(const pm::halfedge_handle& _l_he) const
@@ -771,24 +959,78 @@ const pm::halfedge_handle& Embedding::matching_layout_halfedge(const pm::halfedg
 
 pm::halfedge_handle& Embedding::matching_layout_halfedge(const pm::halfedge_handle& _t_h)
 {
-    LE_ASSERT(_t_h.mesh == &target_mesh());
+    LE_ASSERT(_t_h.mesh == &t_m);
     return t_matching_halfedge[_t_h];
 }
 
-double Embedding::get_vertex_repulsive_energy(const pm::vertex_handle& _t_v, const pm::vertex_handle& _l_v) const
+void Embedding::invalidate_caches()
 {
-    LE_ASSERT(_t_v.mesh == &target_mesh());
-    LE_ASSERT(_l_v.mesh == &layout_mesh());
+    vertex_repulsive_energy.reset();
+    search_graph_cache.reset();
+    face_regions_cache.reset();
+}
 
-    if (!vertex_repulsive_energy.has_value()) {
-        Eigen::MatrixXd vre = compute_vertex_repulsive_energy(*this);
-        vertex_repulsive_energy = target_mesh().vertices().make_attribute<Eigen::VectorXd>();
-        for (const auto t_v : target_mesh().vertices()) {
-            (*vertex_repulsive_energy)[t_v] = vre.row(t_v.idx.value);
+const SearchGraph& Embedding::search_graph() const
+{
+    if (!search_graph_cache.has_value()) {
+        LE_PROFILE_SCOPE("build_search_graph");
+        search_graph_cache.emplace();
+        search_graph_cache->build(*this);
+    }
+    else {
+        LE_PROFILE_COUNT("search_graph_cache_hits", 1);
+    }
+    return *search_graph_cache;
+}
+
+const FaceRegions& Embedding::face_regions() const
+{
+    if (!face_regions_cache.has_value()) {
+        LE_PROFILE_SCOPE("build_face_regions");
+        face_regions_cache.emplace();
+        face_regions_cache->build(*this);
+    }
+    else {
+        LE_PROFILE_COUNT("face_regions_cache_hits", 1);
+    }
+    return *face_regions_cache;
+}
+
+void Embedding::update_search_graph(const std::vector<pm::vertex_handle>& _t_v_new, const std::vector<pm::vertex_handle>& _t_v_path)
+{
+    if (!search_graph_cache.has_value()) {
+        return;
+    }
+    LE_PROFILE_SCOPE("update_search_graph");
+
+    if (!_t_v_new.empty()) {
+        search_graph_cache->update_after_splits(*this, _t_v_new);
+    }
+
+    // Only the vertices and edges of the path change their blocked state
+    for (int i = 0; i < _t_v_path.size(); ++i) {
+        search_graph_cache->update_blocked(*this, _t_v_path[i]);
+        if (i + 1 < _t_v_path.size()) {
+            const auto t_he = pm::halfedge_from_to(_t_v_path[i], _t_v_path[i + 1]);
+            search_graph_cache->update_blocked(*this, t_he.edge());
         }
     }
-    LE_ASSERT(vertex_repulsive_energy.has_value());
-    return (*vertex_repulsive_energy)[_t_v][_l_v.idx.value];
+}
+
+const VertexRepulsiveEnergy& Embedding::vertex_repulsive_energy_fields() const
+{
+    if (!vertex_repulsive_energy.has_value()) {
+        vertex_repulsive_energy.emplace(*this);
+    }
+    LE_ASSERT_EQ(vertex_repulsive_energy->num_vertices(), (int)t_m.vertices().size());
+    return *vertex_repulsive_energy;
+}
+
+double Embedding::get_vertex_repulsive_energy(const pm::vertex_handle& _t_v, const pm::vertex_handle& _l_v) const
+{
+    LE_ASSERT(_t_v.mesh == &target_mesh());
+    LE_ASSERT(_l_v.mesh == &layout_mesh());
+    return vertex_repulsive_energy_fields().field(_l_v)[_t_v];
 }
 
 double Embedding::get_vertex_repulsive_energy(const VirtualVertex& _t_vv, const pm::vertex_handle& _l_v) const
@@ -910,11 +1152,12 @@ bool Embedding::load(std::string filename)
 
 
     // Load target mesh
-    if(!pm::load(tm_file_name, target_mesh(), target_pos()))
+    if(!load_mesh(tm_file_name, target_mesh(), target_pos()))
     {
         std::cerr << "Could not load target mesh object file that was specified in the lem file. Please check again." << std::endl;
         return false;
     }
+    invalidate_caches();
 
     // Load embedding input
     if(!input->load(inp_file_name))
@@ -977,4 +1220,488 @@ bool Embedding::load(std::string filename)
     return true;
 }
 
+namespace
+{
+
+/// Layout of .lemb files (little endian):
+///   BinaryHeader
+///   Layout mesh, input target mesh (each: positions, face offsets, face vertices)
+///   Landmarks (per layout vertex: input target vertex, embedding target vertex)
+///   Embedding target mesh
+///   Paths (layout vertex pairs, offsets, target vertices)
+/// Every array starts at a multiple of 8 bytes. The checksum covers everything after the header.
+constexpr char binary_magic[4] = { 'L', 'E', 'M', 'B' };
+constexpr uint32_t binary_version = 1;
+constexpr uint32_t binary_flag_checksum = 1;
+
+struct BinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    uint32_t header_size;
+    uint64_t payload_size;
+    uint64_t checksum;
+
+    int32_t l_num_vertices;
+    int32_t l_num_faces;
+    int32_t l_num_face_vertices;
+    int32_t ti_num_vertices; // Input target mesh
+    int32_t ti_num_faces;
+    int32_t ti_num_face_vertices;
+    int32_t t_num_vertices; // Embedding target mesh
+    int32_t t_num_faces;
+    int32_t t_num_face_vertices;
+    int32_t num_paths;
+    int32_t num_path_vertices;
+    int32_t reserved;
+};
+static_assert(sizeof(BinaryHeader) == 80, "Unexpected padding in BinaryHeader");
+
+/// FNV-1a
+uint64_t binary_checksum(const char* _data, const size_t _size)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < _size; ++i) {
+        hash ^= (unsigned char)_data[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+struct BinaryWriter
+{
+    std::vector<char> payload;
+
+    template <typename T>
+    void write(const std::vector<T>& _data)
+    {
+        const size_t bytes = _data.size() * sizeof(T);
+        const size_t padded = (bytes + 7) / 8 * 8;
+        const size_t offset = payload.size();
+        payload.resize(offset + padded, 0);
+        if (bytes > 0) {
+            std::memcpy(payload.data() + offset, _data.data(), bytes);
+        }
+    }
+
+    /// Writes positions and faces of the non-removed elements.
+    /// Returns the new index per (old) vertex index, -1 for removed vertices.
+    std::vector<int> write_mesh(const pm::vertex_attribute<tg::pos3>& _pos, int32_t& _num_vertices, int32_t& _num_faces, int32_t& _num_face_vertices)
+    {
+        const auto& m = _pos.mesh();
+        std::vector<int> v_remap(m.all_vertices().size(), -1);
+        std::vector<float> pos;
+        pos.reserve(3 * m.vertices().size());
+        for (const auto v : m.vertices()) {
+            v_remap[v.idx.value] = pos.size() / 3;
+            for (int d = 0; d < 3; ++d) {
+                pos.push_back(_pos[v][d]);
+            }
+        }
+
+        std::vector<int32_t> face_offsets = { 0 };
+        std::vector<int32_t> face_vertices;
+        face_offsets.reserve(m.faces().size() + 1);
+        face_vertices.reserve(3 * m.faces().size());
+        for (const auto f : m.faces()) {
+            for (const auto v : f.vertices()) {
+                face_vertices.push_back(v_remap[v.idx.value]);
+            }
+            face_offsets.push_back(face_vertices.size());
+        }
+
+        _num_vertices = pos.size() / 3;
+        _num_faces = face_offsets.size() - 1;
+        _num_face_vertices = face_vertices.size();
+        write(pos);
+        write(face_offsets);
+        write(face_vertices);
+        return v_remap;
+    }
+};
+
+/// A mesh section written by BinaryWriter::write_mesh. The arrays point directly into the file.
+struct BinaryMesh
+{
+    int32_t num_vertices = 0;
+    int32_t num_faces = 0;
+    const float* pos = nullptr;
+    const int32_t* face_offsets = nullptr;
+    const int32_t* face_vertices = nullptr;
+
+    // Neighbors per vertex (CSR), see build_adjacency
+    std::vector<int32_t> adjacency_offsets;
+    std::vector<int32_t> adjacency;
+
+    void build_adjacency()
+    {
+        adjacency_offsets.assign(num_vertices + 1, 0);
+        for (int i = 0; i < num_faces; ++i) {
+            for (int j = face_offsets[i]; j < face_offsets[i + 1]; ++j) {
+                adjacency_offsets[face_vertices[j] + 1] += 2;
+            }
+        }
+        for (int i = 0; i < num_vertices; ++i) {
+            adjacency_offsets[i + 1] += adjacency_offsets[i];
+        }
+        adjacency.resize(adjacency_offsets.back());
+        std::vector<int32_t> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+        for (int i = 0; i < num_faces; ++i) {
+            const int begin = face_offsets[i];
+            const int end = face_offsets[i + 1];
+            for (int j = begin; j < end; ++j) {
+                const int a = face_vertices[j];
+                const int b = face_vertices[j + 1 < end ? j + 1 : begin];
+                adjacency[fill[a]++] = b;
+                adjacency[fill[b]++] = a;
+            }
+        }
+    }
+
+    /// Whether the faces can be added to a pm::Mesh: No directed edge is used twice,
+    /// no face visits a vertex twice and the faces around each vertex form a single fan.
+    bool is_manifold() const
+    {
+        // Corners of all faces, grouped by vertex
+        struct Corner
+        {
+            int32_t prev; // Vertex before the corner vertex in its face
+            int32_t next; // Vertex after the corner vertex in its face
+        };
+        std::vector<int32_t> corner_offsets(num_vertices + 1, 0);
+        for (int i = 0; i < face_offsets[num_faces]; ++i) {
+            ++corner_offsets[face_vertices[i] + 1];
+        }
+        for (int i = 0; i < num_vertices; ++i) {
+            corner_offsets[i + 1] += corner_offsets[i];
+        }
+        std::vector<Corner> corners(corner_offsets.back());
+        std::vector<int32_t> fill(corner_offsets.begin(), corner_offsets.end() - 1);
+        for (int i = 0; i < num_faces; ++i) {
+            const int begin = face_offsets[i];
+            const int end = face_offsets[i + 1];
+            for (int j = begin; j < end; ++j) {
+                if (std::find(face_vertices + begin, face_vertices + j, face_vertices[j]) != face_vertices + j) {
+                    return false;
+                }
+                const int prev = face_vertices[j > begin ? j - 1 : end - 1];
+                const int next = face_vertices[j + 1 < end ? j + 1 : begin];
+                corners[fill[face_vertices[j]]++] = { prev, next };
+            }
+        }
+
+        std::vector<int32_t> component;
+        for (int v = 0; v < num_vertices; ++v) {
+            const int begin = corner_offsets[v];
+            const int end = corner_offsets[v + 1];
+            for (int i = begin; i < end; ++i) {
+                for (int j = i + 1; j < end; ++j) {
+                    if (corners[i].next == corners[j].next || corners[i].prev == corners[j].prev) {
+                        return false;
+                    }
+                }
+            }
+
+            // Corners sharing an edge belong to the same fan. Label propagation is fine for the small valences here.
+            component.resize(end - begin);
+            for (int i = 0; i < end - begin; ++i) {
+                component[i] = i;
+            }
+            bool changed = true;
+            while (changed) {
+                changed = false;
+                for (int i = begin; i < end; ++i) {
+                    for (int j = begin; j < end; ++j) {
+                        auto& c_i = component[i - begin];
+                        auto& c_j = component[j - begin];
+                        if (corners[i].next == corners[j].prev && c_i != c_j) {
+                            c_i = c_j = std::min(c_i, c_j);
+                            changed = true;
+                        }
+                    }
+                }
+            }
+            for (int i = 0; i < end - begin; ++i) {
+                if (component[i] != 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    /// Whether _a and _b are connected by an edge. Requires build_adjacency.
+    bool adjacent(const int _a, const int _b) const
+    {
+        return std::find(adjacency.begin() + adjacency_offsets[_a], adjacency.begin() + adjacency_offsets[_a + 1], _b) != adjacency.begin() + adjacency_offsets[_a + 1];
+    }
+
+    void build(pm::Mesh& _m, pm::vertex_attribute<tg::pos3>& _pos) const
+    {
+        _m.clear();
+        for (int i = 0; i < num_vertices; ++i) {
+            const auto v = _m.vertices().add();
+            _pos[v] = tg::pos3(pos[3 * i], pos[3 * i + 1], pos[3 * i + 2]);
+        }
+
+        std::vector<pm::vertex_handle> f_vertices;
+        for (int i = 0; i < num_faces; ++i) {
+            f_vertices.clear();
+            for (int j = face_offsets[i]; j < face_offsets[i + 1]; ++j) {
+                f_vertices.push_back(_m.vertices()[face_vertices[j]]);
+            }
+            _m.faces().add(f_vertices);
+        }
+    }
+};
+
+struct BinaryReader
+{
+    const char* data;
+    size_t size;
+    size_t offset = 0;
+
+    /// Pointer to the next _count elements, directly into the file. nullptr if the file is too short.
+    template <typename T>
+    const T* read(const int32_t _count)
+    {
+        if (_count < 0) {
+            return nullptr;
+        }
+        const size_t bytes = (size_t)_count * sizeof(T);
+        const size_t padded = (bytes + 7) / 8 * 8;
+        if (offset + padded > size) {
+            return nullptr;
+        }
+        const T* result = reinterpret_cast<const T*>(data + offset);
+        offset += padded;
+        return result;
+    }
+
+    /// Reads and validates a mesh section written by BinaryWriter::write_mesh. Returns false on malformed data.
+    bool read_mesh(BinaryMesh& _mesh, const int32_t _num_vertices, const int32_t _num_faces, const int32_t _num_face_vertices)
+    {
+        _mesh.num_vertices = _num_vertices;
+        _mesh.num_faces = _num_faces;
+        _mesh.pos = read<float>(3 * _num_vertices);
+        _mesh.face_offsets = read<int32_t>(_num_faces + 1);
+        _mesh.face_vertices = read<int32_t>(_num_face_vertices);
+        if (!_mesh.pos || !_mesh.face_offsets || !_mesh.face_vertices) {
+            return false;
+        }
+        if (_mesh.face_offsets[0] != 0 || _mesh.face_offsets[_num_faces] != _num_face_vertices) {
+            return false;
+        }
+        for (int i = 0; i < _num_faces; ++i) {
+            if (_mesh.face_offsets[i + 1] < _mesh.face_offsets[i] + 3 || _mesh.face_offsets[i + 1] > _num_face_vertices) {
+                return false;
+            }
+            for (int j = _mesh.face_offsets[i]; j < _mesh.face_offsets[i + 1]; ++j) {
+                if (_mesh.face_vertices[j] < 0 || _mesh.face_vertices[j] >= _num_vertices) {
+                    return false;
+                }
+            }
+        }
+        return _mesh.is_manifold();
+    }
+};
+
+}
+
+bool Embedding::save_binary(const std::string& _filename, const bool _checksum) const
+{
+    BinaryHeader header = {};
+    std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+    header.version = binary_version;
+    header.flags = _checksum ? binary_flag_checksum : 0;
+    header.header_size = sizeof(BinaryHeader);
+
+    BinaryWriter writer;
+    const auto l_remap = writer.write_mesh(input->l_pos, header.l_num_vertices, header.l_num_faces, header.l_num_face_vertices);
+    const auto ti_remap = writer.write_mesh(input->t_pos, header.ti_num_vertices, header.ti_num_faces, header.ti_num_face_vertices);
+
+    std::vector<int32_t> landmarks;
+    landmarks.reserve(2 * header.l_num_vertices);
+    for (const auto l_v : layout_mesh().vertices()) {
+        const auto& t_v_input = input->l_matching_vertex[l_v];
+        const auto& t_v = l_matching_vertex[l_v];
+        landmarks.push_back(t_v_input.is_valid() ? ti_remap[t_v_input.idx.value] : -1);
+        landmarks.push_back(t_v.is_valid() ? t_v.idx.value : -1); // Remapped below
+    }
+
+    BinaryWriter target_writer; // Written after the landmarks, which need the remapping
+    const auto t_remap = target_writer.write_mesh(t_pos, header.t_num_vertices, header.t_num_faces, header.t_num_face_vertices);
+    for (int i = 1; i < (int)landmarks.size(); i += 2) {
+        if (landmarks[i] >= 0) {
+            landmarks[i] = t_remap[landmarks[i]];
+        }
+    }
+    writer.write(landmarks);
+    writer.payload.insert(writer.payload.end(), target_writer.payload.begin(), target_writer.payload.end());
+
+    // One path per embedded layout edge
+    std::vector<int32_t> path_endpoints;
+    std::vector<int32_t> path_offsets = { 0 };
+    std::vector<int32_t> path_vertices;
+    for (const auto l_e : layout_mesh().edges()) {
+        const auto l_he = l_e.halfedgeA();
+        if (!is_embedded(l_he)) {
+            continue;
+        }
+        path_endpoints.push_back(l_remap[l_he.vertex_from().idx.value]);
+        path_endpoints.push_back(l_remap[l_he.vertex_to().idx.value]);
+        for (const auto t_v : get_embedded_path(l_he)) {
+            path_vertices.push_back(t_remap[t_v.idx.value]);
+        }
+        path_offsets.push_back(path_vertices.size());
+    }
+    header.num_paths = path_offsets.size() - 1;
+    header.num_path_vertices = path_vertices.size();
+    writer.write(path_endpoints);
+    writer.write(path_offsets);
+    writer.write(path_vertices);
+
+    header.payload_size = writer.payload.size();
+    header.checksum = _checksum ? binary_checksum(writer.payload.data(), writer.payload.size()) : 0;
+
+    std::ofstream file(_filename + ".lemb", std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Could not create lemb file." << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(writer.payload.data(), writer.payload.size());
+    return file.good();
+}
+
+bool Embedding::load_binary(const std::string& _filename, const bool _verify_checksum)
+{
+    const MappedFile file(_filename + ".lemb");
+    if (!file.is_open()) {
+        std::cerr << "Could not open lemb file." << std::endl;
+        return false;
+    }
+
+    BinaryHeader header;
+    if (file.size() < sizeof(BinaryHeader)) {
+        std::cerr << "Invalid lemb file: Too short." << std::endl;
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(BinaryHeader));
+    if (std::memcmp(header.magic, binary_magic, sizeof(binary_magic)) != 0 || header.header_size != sizeof(BinaryHeader)) {
+        std::cerr << "Invalid lemb file: Unknown format." << std::endl;
+        return false;
+    }
+    if (header.version != binary_version) {
+        std::cerr << "Unsupported lemb file version " << header.version << "." << std::endl;
+        return false;
+    }
+    if (file.size() - sizeof(BinaryHeader) != header.payload_size) {
+        std::cerr << "Invalid lemb file: Truncated." << std::endl;
+        return false;
+    }
+
+    const char* payload = file.data() + sizeof(BinaryHeader);
+    if (_verify_checksum && (header.flags & binary_flag_checksum)) {
+        if (binary_checksum(payload, header.payload_size) != header.checksum) {
+            std::cerr << "Invalid lemb file: Checksum mismatch." << std::endl;
+            return false;
+        }
+    }
+
+    // Validate all sections before anything is replaced, so a rejected file leaves this Embedding untouched.
+    BinaryReader reader = { payload, header.payload_size };
+    BinaryMesh l_mesh;
+    BinaryMesh ti_mesh;
+    BinaryMesh t_mesh;
+    if (!reader.read_mesh(l_mesh, header.l_num_vertices, header.l_num_faces, header.l_num_face_vertices) ||
+        !reader.read_mesh(ti_mesh, header.ti_num_vertices, header.ti_num_faces, header.ti_num_face_vertices)) {
+        std::cerr << "Invalid lemb file: Malformed input meshes." << std::endl;
+        return false;
+    }
+    const int32_t* landmarks = reader.read<int32_t>(2 * header.l_num_vertices);
+    if (!landmarks || !reader.read_mesh(t_mesh, header.t_num_vertices, header.t_num_faces, header.t_num_face_vertices)) {
+        std::cerr << "Invalid lemb file: Malformed target mesh." << std::endl;
+        return false;
+    }
+
+    for (int i = 0; i < header.l_num_vertices; ++i) {
+        const int t_v_input = landmarks[2 * i];
+        const int t_v = landmarks[2 * i + 1];
+        if (t_v_input >= header.ti_num_vertices || t_v < 0 || t_v >= header.t_num_vertices) {
+            std::cerr << "Invalid lemb file: Malformed landmarks." << std::endl;
+            return false;
+        }
+    }
+
+    const int32_t* path_endpoints = reader.read<int32_t>(2 * header.num_paths);
+    const int32_t* path_offsets = reader.read<int32_t>(header.num_paths + 1);
+    const int32_t* path_vertices = reader.read<int32_t>(header.num_path_vertices);
+    if (!path_endpoints || !path_offsets || !path_vertices) {
+        std::cerr << "Invalid lemb file: Malformed paths." << std::endl;
+        return false;
+    }
+    if (header.num_paths > 0) {
+        l_mesh.build_adjacency();
+        t_mesh.build_adjacency();
+    }
+    auto undirected = [] (const int _a, const int _b) { return std::make_pair(std::min(_a, _b), std::max(_a, _b)); };
+    std::set<std::pair<int, int>> embedded_l_edges;
+    std::set<std::pair<int, int>> used_t_edges;
+    for (int i = 0; i < header.num_paths; ++i) {
+        const int l_v_from = path_endpoints[2 * i];
+        const int l_v_to = path_endpoints[2 * i + 1];
+        const int begin = path_offsets[i];
+        const int end = path_offsets[i + 1];
+        bool valid = l_v_from >= 0 && l_v_from < header.l_num_vertices
+                  && l_v_to >= 0 && l_v_to < header.l_num_vertices
+                  && l_mesh.adjacent(l_v_from, l_v_to)
+                  && embedded_l_edges.insert(undirected(l_v_from, l_v_to)).second
+                  && 0 <= begin && begin + 2 <= end && end <= header.num_path_vertices
+                  && path_vertices[begin] == landmarks[2 * l_v_from + 1]
+                  && path_vertices[end - 1] == landmarks[2 * l_v_to + 1];
+        for (int j = begin; valid && j < end; ++j) {
+            valid = path_vertices[j] >= 0 && path_vertices[j] < header.t_num_vertices
+                 && (j == begin || t_mesh.adjacent(path_vertices[j - 1], path_vertices[j]))
+                 && (j == begin || used_t_edges.insert(undirected(path_vertices[j - 1], path_vertices[j])).second);
+        }
+        if (!valid) {
+            std::cerr << "Invalid lemb file: Malformed path " << i << "." << std::endl;
+            return false;
+        }
+    }
+
+    // Replace contents
+    l_mesh.build(input->l_m, input->l_pos);
+    ti_mesh.build(input->t_m, input->t_pos);
+    t_mesh.build(t_m, t_pos);
+    invalidate_caches();
+
+    input->l_matching_vertex.clear();
+    l_matching_vertex.clear();
+    t_matching_vertex.clear();
+    t_matching_halfedge.clear();
+    for (const auto l_v : layout_mesh().vertices()) {
+        const int t_v_input = landmarks[2 * l_v.idx.value];
+        const int t_v = landmarks[2 * l_v.idx.value + 1];
+        if (t_v_input >= 0) {
+            input->l_matching_vertex[l_v] = input->t_m.vertices()[t_v_input];
+        }
+        l_matching_vertex[l_v] = t_m.vertices()[t_v];
+        t_matching_vertex[t_m.vertices()[t_v]] = l_v;
+    }
+
+    for (int i = 0; i < header.num_paths; ++i) {
+        const auto l_he = pm::halfedge_from_to(layout_mesh().vertices()[path_endpoints[2 * i]], layout_mesh().vertices()[path_endpoints[2 * i + 1]]);
+        for (int j = path_offsets[i]; j + 1 < path_offsets[i + 1]; ++j) {
+            const auto t_he = pm::halfedge_from_to(t_m.vertices()[path_vertices[j]], t_m.vertices()[path_vertices[j + 1]]);
+            t_matching_halfedge[t_he] = l_he;
+            t_matching_halfedge[t_he.opposite()] = l_he.opposite();
+        }
+    }
+
+    return true;
+}
+
 }
@@ -1,9 +1,13 @@
 #pragma once
 
 #include <LayoutEmbedding/EmbeddingInput.hh>
+#include <LayoutEmbedding/FaceRegions.hh>
 #include <LayoutEmbedding/LayoutGeneration.hh>
+#include <LayoutEmbedding/SearchGraph.hh>
+#include <LayoutEmbedding/VertexRepulsiveEnergy.hh>
 #include <LayoutEmbedding/VirtualVertex.hh>
 #include <LayoutEmbedding/VirtualPath.hh>
+#include <LayoutEmbedding/VirtualVertexAttribute.hh>
 #include <polymesh/formats/obj.hh>
 
 #include <Eigen/Dense>
@@ -62,6 +66,19 @@ public:
         ShortestPathMetric _metric = ShortestPathMetric::Geodesic
     ) const;
 
+    /// Shortest path w.r.t. a user-supplied metric:
+    /// A step between two virtual vertices costs their Euclidean distance, scaled by the mean of their weights.
+    /// Weights must be non-negative and cover all vertices and edges of the current target mesh.
+    VirtualPath find_shortest_path(
+        const pm::halfedge_handle& _t_h_sector_start, // Target halfedge, at the beginning of a sector
+        const pm::halfedge_handle& _t_h_sector_end,   // Target halfedge, at the beginning of a sector
+        const VirtualVertexAttribute<double>& _weights
+    ) const;
+    VirtualPath find_shortest_path(
+        const pm::halfedge_handle& _l_he, // Layout halfedge
+        const VirtualVertexAttribute<double>& _weights
+    ) const;
+
     double path_length(const VirtualPath& _path) const;
 
     void embed_path(const pm::halfedge_handle& _l_he, const VirtualPath& _path);
@@ -70,7 +87,12 @@ public:
     void unembed_path(const pm::edge_handle& _l_e);
 
     std::vector<pm::vertex_handle> get_embedded_path(const pm::halfedge_handle& _l_he) const;
+    /// Target faces inside the patch of the layout face _l_f, sorted by index.
+    /// At least one halfedge of _l_f has to be embedded. Only a complete patch if all of them are.
     std::vector<pm::face_handle> get_patch(const pm::face_handle& _l_f) const;
+
+    /// Target faces in the region (see FaceRegions) left of the target halfedge _t_h, sorted by index.
+    std::vector<pm::face_handle> get_region(const pm::halfedge_handle& _t_h) const;
     double embedded_path_length(const pm::halfedge_handle& _l_he) const;
     double embedded_path_length(const pm::edge_handle& _l_e) const;
     double total_embedded_path_length() const;
@@ -81,23 +103,58 @@ public:
 
     bool load(std::string filename);
 
+    /// Binary alternative to save / load: A single <filename>.lemb file holding the layout, the landmarks,
+    /// the input and refined target meshes, and one vertex list per embedded path, all in flat arrays.
+    /// Loading maps the file into memory and replaces the contents of the EmbeddingInput this Embedding refers to.
+    /// The optional checksum replaces the per-path validation of the text format.
+    bool save_binary(const std::string& _filename, const bool _checksum = true) const;
+    bool load_binary(const std::string& _filename, const bool _verify_checksum = true);
+
+    /// Flat snapshot of the target mesh connectivity used by find_shortest_path.
+    /// Built on first use and kept up to date by embed_path / unembed_path.
+    const SearchGraph& search_graph() const;
+
+    /// Labeling of target faces by the region (bounded by embedded paths) they lie in.
+    /// Built on first use and kept up to date by embed_path / unembed_path.
+    const FaceRegions& face_regions() const;
+
+    /// Drops all data derived from the target mesh (search graph, face regions, vertex repulsive energy).
+    /// Must be called after modifying the target mesh, its positions or the halfedge matching via the non-const getters.
+    /// (embed_path / unembed_path keep the caches up to date by themselves.)
+    void invalidate_caches();
+
     // Getters.
     const pm::Mesh& layout_mesh() const; // This will always refer to the original l_m in the input
     const pm::vertex_attribute<tg::pos3>& layout_pos() const;
     pm::vertex_attribute<tg::pos3>& layout_pos();
     const pm::Mesh& target_mesh() const; // This refers to the local copy contained in this Embedding (can be different from the original target mesh due to local refinements).
-    pm::Mesh& target_mesh();
+    pm::Mesh& target_mesh(); // Call invalidate_caches() after modifying the mesh through this.
     const pm::vertex_attribute<tg::pos3>& target_pos() const;
-    pm::vertex_attribute<tg::pos3>& target_pos();
+    pm::vertex_attribute<tg::pos3>& target_pos(); // Call invalidate_caches() after modifying positions through this.
     const pm::vertex_handle matching_target_vertex(const pm::vertex_handle& _l_v) const;
     const pm::vertex_handle matching_layout_vertex(const pm::vertex_handle& _t_v) const;
     const pm::halfedge_handle& matching_layout_halfedge(const pm::halfedge_handle& _t_h) const;
-    pm::halfedge_handle& matching_layout_halfedge(const pm::halfedge_handle& _t_h);
+    pm::halfedge_handle& matching_layout_halfedge(const pm::halfedge_handle& _t_h); // Call invalidate_caches() after assigning through this.
 
     double get_vertex_repulsive_energy(const pm::vertex_handle& _t_v, const pm::vertex_handle& _l_v) const;
     double get_vertex_repulsive_energy(const VirtualVertex& _t_vv, const pm::vertex_handle& _l_v) const;
 
 private:
+    /// Search kernel shared by all metrics. The Metric policy provides
+    /// distance(dist_from, node_from, arc, node_to) and heuristic(node_to), see Embedding.cc.
+    template <typename Metric>
+    VirtualPath find_shortest_path_kernel(
+        const pm::halfedge_handle& _t_h_sector_start,
+        const pm::halfedge_handle& _t_h_sector_end,
+        const Metric& _metric
+    ) const;
+
+    const VertexRepulsiveEnergy& vertex_repulsive_energy_fields() const;
+
+    /// Patches the cached search graph (if any) after (un)embedding the target vertex path _t_v_path,
+    /// during which the vertices _t_v_new were inserted by edge splits.
+    void update_search_graph(const std::vector<pm::vertex_handle>& _t_v_new, const std::vector<pm::vertex_handle>& _t_v_path);
+
     EmbeddingInput* input;
     pm::Mesh t_m; // Target mesh. Copy.
     pm::vertex_attribute<tg::pos3> t_pos; // Target mesh positions. Copy.
@@ -107,8 +164,14 @@ private:
     pm::halfedge_attribute<pm::halfedge_handle> t_matching_halfedge;
 
     // Cache for the energy used for vertex repulsive path tracing [Praun2001].
-    // Computed lazily when required. Access via get_vertex_repulsive_energy.
-    mutable std::optional<pm::vertex_attribute<Eigen::VectorXd>> vertex_repulsive_energy;
+    // Computed lazily when required. Access via vertex_repulsive_energy_fields.
+    mutable std::optional<VertexRepulsiveEnergy> vertex_repulsive_energy;
+
+    // Computed lazily when required. Access via search_graph.
+    mutable std::optional<SearchGraph> search_graph_cache;
+
+    // Computed lazily when required. Access via face_regions.
+    mutable std::optional<FaceRegions> face_regions_cache;
 };
 
 }
@@ -1,10 +1,29 @@
 #include "EmbeddingInput.hh"
 
 #include <LayoutEmbedding/LayoutGeneration.hh>
+#include <LayoutEmbedding/MeshIO.hh>
+#include <LayoutEmbedding/Util/MappedFile.hh>
+#include <LayoutEmbedding/Util/Parsing.hh>
 
 namespace LayoutEmbedding
 {
 
+namespace
+{
+
+void print_load_timings(const MeshLoadTimings& _timings)
+{
+    std::cout << "Loaded in " << _timings.total() << " s ";
+    if (_timings.fallback) {
+        std::cout << "(pm::load)." << std::endl;
+    }
+    else {
+        std::cout << "(map " << _timings.map << " s, parse " << _timings.parse << " s, build " << _timings.build << " s)." << std::endl;
+    }
+}
+
+}
+
 EmbeddingInput::EmbeddingInput() :
     l_pos(l_m),
     l_matching_vertex(l_m),
@@ -197,13 +216,13 @@ bool EmbeddingInput::load(const std::string& _path_prefix)
 
 
     // Load layout mesh into input
-    if(!pm::load(lm_file_name, l_m, l_pos))
+    if(!load_mesh(lm_file_name, l_m, l_pos))
     {
         std::cerr << "Could not load layout mesh object file that was specified in the inp file. Please check again." << std::endl;
         return false;
     }
     // Load target mesh into input
-    if(!pm::load(tim_file_name, t_m, t_pos))
+    if(!load_mesh(tim_file_name, t_m, t_pos))
     {
         std::cerr << "Could not load target mesh object file that was specified in the inp file. Please check again." << std::endl;
         return false;
@@ -220,21 +239,25 @@ bool EmbeddingInput::load(
         const fs::path& _layout_path,
         const fs::path& _target_path)
 {
+    MeshLoadTimings timings;
+
     // Load layout
-    LE_ASSERT(pm::load(_layout_path, l_m, l_pos));
+    LE_ASSERT(load_mesh(_layout_path, l_m, l_pos, MeshLoadSettings(), &timings));
     std::cout << "Layout Mesh: ";
     std::cout << l_m.vertices().size() << " vertices, ";
     std::cout << l_m.edges().size() << " edges, ";
     std::cout << l_m.faces().size() << " faces. ";
     std::cout << "χ = " << pm::euler_characteristic(l_m) << std::endl;
+    print_load_timings(timings);
 
     // Load target mesh
-    LE_ASSERT(pm::load(_target_path, t_m, t_pos));
+    LE_ASSERT(load_mesh(_target_path, t_m, t_pos, MeshLoadSettings(), &timings));
     std::cout << "Target Mesh: ";
     std::cout << t_m.vertices().size() << " vertices, ";
     std::cout << t_m.edges().size() << " edges, ";
     std::cout << t_m.faces().size() << " faces. ";
     std::cout << "χ = " << pm::euler_characteristic(t_m) << std::endl;
+    print_load_timings(timings);
 
 //    if (pm::euler_characteristic(l_m) != pm::euler_characteristic(t_m)) {
 //        std::cout << "Euler characteristic does not match. Skipping." << std::endl;
@@ -320,27 +343,44 @@ void EmbeddingInput::invert_layout()
 
 std::vector<int> load_landmarks(const fs::path& _file_path, const LandmarkFormat& _format)
 {
-    std::ifstream f { _file_path };
     std::vector<int> result;
+    const MappedFile file(_file_path);
+    if (!file.is_open()) {
+        return result;
+    }
 
+    // Records are read until the first malformed one
+    const char* p = file.data();
+    const char* end = file.data() + file.size();
     switch (_format) {
         case LandmarkFormat::id_x_y_z:
         {
-            while (f.good()) {
-                int id;
-                float x, y, z; // Unused
-                f >> id >> x >> y >> z;
-                if (f.good()) {
+            while (p < end) {
+                const char* line_end = next_line(p, end);
+                if (!at_line_end(p, line_end)) {
+                    int id;
+                    float x, y, z; // Unused
+                    if (!parse_int(p, line_end, id) || !parse_float(p, line_end, x) || !parse_float(p, line_end, y) || !parse_float(p, line_end, z)) {
+                        break;
+                    }
                     result.push_back(id);
                 }
+                p = line_end;
             }
             break;
         }
         case LandmarkFormat::id:
         {
-            while (f.good()) {
-                int id;
-                f >> id;
+            while (p < end) {
+                const char* line_end = next_line(p, end);
+                while (!at_line_end(p, line_end)) {
+                    int id;
+                    if (!parse_int(p, line_end, id)) {
+                        return result;
+                    }
+                    result.push_back(id);
+                }
+                p = line_end;
             }
             break;
         }
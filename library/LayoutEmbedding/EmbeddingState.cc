@@ -3,6 +3,7 @@
 #include <LayoutEmbedding/UnionFind.hh>
 #include <LayoutEmbedding/VirtualPathConflictSentinel.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/Profiling.hh>
 
 namespace LayoutEmbedding {
 
@@ -32,6 +33,7 @@ void EmbeddingState::extend(const pm::edge_index& _l_ei, const VirtualPath& _pat
 
 void EmbeddingState::compute_candidate_path(const pm::edge_index& _l_ei)
 {
+    LE_PROFILE_SCOPE("candidate_path");
     const Embedding& c_em = em; // We don't want to modify the embedding in this method.
     const auto& l_e = c_em.layout_mesh().edges()[_l_ei];
 
@@ -58,6 +60,7 @@ void EmbeddingState::compute_all_candidate_paths()
 
 void EmbeddingState::detect_candidate_path_conflicts()
 {
+    LE_PROFILE_SCOPE("detect_conflicts");
     const Embedding& c_em = em; // We don't want to modify the embedding in this method.
     conflicts.clear();
 
@@ -143,6 +146,7 @@ double EmbeddingState::unembedded_cost() const
 
 HashValue EmbeddingState::hash() const
 {
+    LE_PROFILE_SCOPE("hash");
     HashValue h = 0;
     for (const auto l_e : em.layout_mesh().edges()) {
         if (em.is_embedded(l_e)) {
@@ -0,0 +1,244 @@
+#include "FaceRegions.hh"
+
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+
+namespace LayoutEmbedding {
+
+void FaceRegions::build(const Embedding& _em)
+{
+    const auto& t_m = _em.target_mesh();
+
+    face_region.assign(t_m.all_faces().size(), -1);
+    region_faces.clear();
+    region_size.clear();
+    free_regions.clear();
+
+    for (const auto t_f_seed : t_m.faces()) {
+        if (face_region[t_f_seed.idx.value] >= 0) {
+            continue;
+        }
+
+        // Flood fill without crossing embedded paths
+        const int r = new_region();
+        auto& faces = region_faces[r];
+        faces.push_back(t_f_seed.idx.value);
+        face_region[t_f_seed.idx.value] = r;
+        for (int i = 0; i < (int)faces.size(); ++i) {
+            const auto t_f = t_m[pm::face_index(faces[i])];
+            for (const auto t_h : t_f.halfedges()) {
+                const auto t_f_opp = t_h.opposite_face();
+                if (t_f_opp.is_invalid() || face_region[t_f_opp.idx.value] >= 0 || _em.is_blocked(t_h.edge())) {
+                    continue;
+                }
+                face_region[t_f_opp.idx.value] = r;
+                faces.push_back(t_f_opp.idx.value);
+            }
+        }
+        region_size[r] = faces.size();
+    }
+}
+
+void FaceRegions::update_after_embed(const Embedding& _em, const int _num_faces_before, const std::vector<pm::vertex_handle>& _t_v_path)
+{
+    LE_ASSERT_GEQ(_t_v_path.size(), 2);
+    const auto& t_m = _em.target_mesh();
+    const auto t_he = pm::halfedge_from_to(_t_v_path[0], _t_v_path[1]);
+    LE_ASSERT(t_he.is_valid());
+
+    // Determine the region the path was embedded in.
+    // The first interior path vertex was not blocked, so all of its (old) faces lie in that region.
+    // A path consisting of a single edge cannot have caused any splits, so both of its faces are old.
+    int r = -1;
+    if (_t_v_path.size() >= 3) {
+        for (const auto t_f : _t_v_path[1].faces()) {
+            if (t_f.is_valid() && t_f.idx.value < _num_faces_before) {
+                r = face_region[t_f.idx.value];
+                break;
+            }
+        }
+    }
+    else {
+        for (const auto t_f : { t_he.face(), t_he.opposite_face() }) {
+            if (t_f.is_valid()) {
+                r = face_region[t_f.idx.value];
+                break;
+            }
+        }
+    }
+    LE_ASSERT_GEQ(r, 0);
+
+    // Faces created by the splits along the path
+    const int num_faces = t_m.all_faces().size();
+    face_region.resize(num_faces, -1);
+    for (int i = _num_faces_before; i < num_faces; ++i) {
+        if (t_m[pm::face_index(i)].is_removed()) {
+            continue;
+        }
+        face_region[i] = r;
+        region_faces[r].push_back(i);
+        ++region_size[r];
+    }
+
+    // A path can only split its region if both of its endpoints lie on the region boundary,
+    // i.e. if other paths are already embedded at both endpoints.
+    auto has_other_paths = [&] (const pm::vertex_handle& _t_v, const pm::edge_handle& _t_e_own) {
+        for (const auto t_e : _t_v.edges()) {
+            if (t_e != _t_e_own && _em.is_blocked(t_e)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    const auto t_he_last = pm::halfedge_from_to(_t_v_path[_t_v_path.size() - 2], _t_v_path.back());
+    if (!has_other_paths(_t_v_path.front(), t_he.edge()) || !has_other_paths(_t_v_path.back(), t_he_last.edge())) {
+        return;
+    }
+
+    const auto t_f_left = t_he.face();
+    const auto t_f_right = t_he.opposite_face();
+    if (t_f_left.is_invalid() || t_f_right.is_invalid()) {
+        return;
+    }
+
+    // Flood fill from both sides of the path in lockstep.
+    // Stop as soon as they meet (no split) or one side runs out of faces (that side was cut off and is the smaller one).
+    face_stamp.resize(num_faces, 0);
+    current_stamp += 2;
+    const int stamp[2] = { current_stamp, current_stamp + 1 };
+
+    std::vector<int> side[2] = { { t_f_left.idx.value }, { t_f_right.idx.value } };
+    face_stamp[t_f_left.idx.value] = stamp[0];
+    face_stamp[t_f_right.idx.value] = stamp[1];
+    int head[2] = { 0, 0 };
+    while (true) {
+        for (int s = 0; s < 2; ++s) {
+            if (head[s] == (int)side[s].size()) {
+                relabel(side[s], r, new_region());
+                return;
+            }
+
+            const auto t_f = t_m[pm::face_index(side[s][head[s]++])];
+            for (const auto t_h : t_f.halfedges()) {
+                const auto t_f_opp = t_h.opposite_face();
+                if (t_f_opp.is_invalid() || _em.is_blocked(t_h.edge())) {
+                    continue;
+                }
+                const int i_opp = t_f_opp.idx.value;
+                if (face_stamp[i_opp] == stamp[1 - s]) {
+                    return; // Both sides are connected
+                }
+                if (face_stamp[i_opp] != stamp[s]) {
+                    face_stamp[i_opp] = stamp[s];
+                    side[s].push_back(i_opp);
+                }
+            }
+        }
+    }
+}
+
+void FaceRegions::update_after_unembed(const Embedding& _em, const std::vector<pm::vertex_handle>& _t_v_path)
+{
+    for (int i = 0; i + 1 < (int)_t_v_path.size(); ++i) {
+        const auto t_he = pm::halfedge_from_to(_t_v_path[i], _t_v_path[i + 1]);
+        LE_ASSERT(t_he.is_valid());
+        if (t_he.face().is_invalid() || t_he.opposite_face().is_invalid()) {
+            continue;
+        }
+
+        // Merge the smaller region into the larger one
+        int r_a = region(t_he.face());
+        int r_b = region(t_he.opposite_face());
+        if (r_a == r_b) {
+            continue;
+        }
+        if (region_size[r_a] < region_size[r_b]) {
+            std::swap(r_a, r_b);
+        }
+        const auto faces = std::move(region_faces[r_b]);
+        region_faces[r_b].clear();
+        relabel(faces, r_b, r_a);
+    }
+}
+
+int FaceRegions::region(const pm::face_handle& _t_f) const
+{
+    LE_ASSERT(_t_f.is_valid());
+    LE_ASSERT_L(_t_f.idx.value, (int)face_region.size());
+    return face_region[_t_f.idx.value];
+}
+
+std::vector<pm::face_handle> FaceRegions::faces(const pm::Mesh& _t_m, const int _region) const
+{
+    LE_ASSERT_GEQ(_region, 0);
+    LE_ASSERT_L(_region, num_regions());
+
+    std::vector<int> indices;
+    indices.reserve(region_size[_region]);
+    for (const int i : region_faces[_region]) {
+        if (face_region[i] == _region) {
+            indices.push_back(i);
+        }
+    }
+    std::sort(indices.begin(), indices.end());
+    indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+    LE_ASSERT_EQ((int)indices.size(), region_size[_region]);
+
+    std::vector<pm::face_handle> result;
+    result.reserve(indices.size());
+    for (const int i : indices) {
+        result.push_back(_t_m[pm::face_index(i)]);
+    }
+    return result;
+}
+
+int FaceRegions::num_regions() const
+{
+    return region_faces.size();
+}
+
+int FaceRegions::new_region()
+{
+    if (!free_regions.empty()) {
+        const int r = free_regions.back();
+        free_regions.pop_back();
+        return r;
+    }
+    region_faces.emplace_back();
+    region_size.push_back(0);
+    return num_regions() - 1;
+}
+
+void FaceRegions::relabel(const std::vector<int>& _faces, const int _region_from, const int _region_to)
+{
+    int moved = 0;
+    for (const int i : _faces) {
+        if (face_region[i] == _region_from) {
+            face_region[i] = _region_to;
+            region_faces[_region_to].push_back(i);
+            ++moved;
+        }
+    }
+    region_size[_region_from] -= moved;
+    region_size[_region_to] += moved;
+
+    if (region_size[_region_from] == 0) {
+        region_faces[_region_from].clear();
+        free_regions.push_back(_region_from);
+    }
+    else if ((int)region_faces[_region_from].size() > 2 * region_size[_region_from]) {
+        compact(_region_from);
+    }
+}
+
+void FaceRegions::compact(const int _region)
+{
+    auto& faces = region_faces[_region];
+    faces.erase(std::remove_if(faces.begin(), faces.end(), [&] (int i) { return face_region[i] != _region; }), faces.end());
+    std::sort(faces.begin(), faces.end());
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+}
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <polymesh/pm.hh>
+
+#include <vector>
+
+namespace LayoutEmbedding {
+
+class Embedding;
+
+/// Labels the faces of an Embedding's target mesh by the region they lie in,
+/// i.e. by the connected components of faces w.r.t. edges that are not blocked by embedded paths.
+/// Once all layout edges are embedded, the regions are exactly the patches of the layout faces.
+///
+/// Kept up to date incrementally:
+/// Faces created by edge splits inherit the region of the path that caused the splits.
+/// If a new path splits its region in two, only the faces of the smaller side are relabeled.
+/// If removing a path merges two regions, only the faces of the smaller one are relabeled.
+///
+/// Per region, the member faces are kept in a list, so a region can be enumerated in O(region size).
+/// Faces that left a region stay in its list as stale entries until it is compacted.
+struct FaceRegions
+{
+    std::vector<int> face_region; // Per target face
+    std::vector<std::vector<int>> region_faces; // Per region. Can contain stale and duplicate entries.
+    std::vector<int> region_size; // Per region. Number of faces actually labeled with the region.
+    std::vector<int> free_regions; // Unused region labels (after merges)
+
+    /// Labels all faces from scratch.
+    void build(const Embedding& _em);
+
+    /// Call after embedding the target vertex path _t_v_path.
+    /// Faces with indices of at least _num_faces_before were created by edge splits along the path.
+    void update_after_embed(const Embedding& _em, const int _num_faces_before, const std::vector<pm::vertex_handle>& _t_v_path);
+
+    /// Call after unembedding the target vertex path _t_v_path.
+    void update_after_unembed(const Embedding& _em, const std::vector<pm::vertex_handle>& _t_v_path);
+
+    int region(const pm::face_handle& _t_f) const;
+
+    /// All faces of the region, sorted by index.
+    std::vector<pm::face_handle> faces(const pm::Mesh& _t_m, const int _region) const;
+
+    int num_regions() const;
+
+private:
+    // Scratch space for the two-sided flood fill in update_after_embed.
+    // Stamped per search, so it never has to be cleared.
+    std::vector<int> face_stamp;
+    int current_stamp = 0;
+
+    int new_region();
+    void relabel(const std::vector<int>& _faces, const int _region_from, const int _region_to);
+    void compact(const int _region);
+};
+
+}
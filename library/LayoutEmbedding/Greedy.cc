@@ -1,35 +1,79 @@
 #include "Greedy.hh"
 
+#include <LayoutEmbedding/Connectivity.hh>
 #include <LayoutEmbedding/IGLMesh.hh>
 #include <LayoutEmbedding/UnionFind.hh>
 #include <LayoutEmbedding/VirtualPort.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/Profiling.hh>
 
 #include <algorithm>
+#include <array>
+#include <optional>
 #include <set>
 #include <queue>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace LayoutEmbedding {
 
 namespace {
 
+/// Scratch space of swirl_detection, reused across calls (one per thread).
+/// Per target vertex values are only valid if their stamp matches the current one,
+/// so no per-call allocation or clearing over the whole mesh is necessary.
+struct SwirlWorkspace
+{
+    std::vector<int> indicator;
+    std::vector<double> distance;
+    std::vector<unsigned int> stamp;
+    unsigned int current_stamp = 0;
+
+    void begin(const int _num_vertices)
+    {
+        if ((int)stamp.size() < _num_vertices) {
+            indicator.resize(_num_vertices);
+            distance.resize(_num_vertices);
+            stamp.resize(_num_vertices, 0);
+        }
+        if (++current_stamp == 0) {
+            std::fill(stamp.begin(), stamp.end(), 0);
+            current_stamp = 1;
+        }
+    }
+
+    void touch(const pm::vertex_handle& _v)
+    {
+        if (stamp[_v.idx.value] != current_stamp) {
+            stamp[_v.idx.value] = current_stamp;
+            indicator[_v.idx.value] = 0;
+            distance[_v.idx.value] = std::numeric_limits<double>::infinity();
+        }
+    }
+
+    int& indicator_at(const pm::vertex_handle& _v) { touch(_v); return indicator[_v.idx.value]; }
+    double& distance_at(const pm::vertex_handle& _v) { touch(_v); return distance[_v.idx.value]; }
+};
+
 /// Heuristic detection of paths that might introduce swirls after insertion.
 /// For each vertex around the face that is incident to _l_he on the left,
 /// a shortest path towards the given path is traced.
 /// If the path is hit from the right side (instead of the left), this is considered a potential swirl.
 /// Returns true if a potential swirl is detected, false otherwise.
-bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const VirtualPath& _path)
+/// Only reads the Embedding, so it can be called concurrently for different paths.
+bool swirl_detection(const Embedding& _em, const pm::halfedge_handle& _l_he, const VirtualPath& _path)
 {
-    const pm::Mesh& l_m = _em.layout_mesh();
     const pm::Mesh& t_m = _em.target_mesh();
     const pm::vertex_attribute<tg::pos3>& t_pos = _em.target_pos();
 
+    thread_local SwirlWorkspace ws;
+    ws.begin(t_m.all_vertices().size());
+
     // Walk along the VertexEdgePath and mark the vertices directly left and right of it with a special attribute:
     // The indicator attribute assigns each vertex a value in {-1, 0, 1},
     // -1 meaning it is directly on the left of the arc,
     // 1 meaning it is directly on the right of the arc,
     // 0 otherwise.
-    pm::vertex_attribute<int> t_indicator(t_m);
 
     LE_ASSERT(is_real_vertex(_path.front()));
     LE_ASSERT(is_real_vertex(_path.back()));
@@ -50,7 +94,7 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
                 while (vh_current != vh_end) {
                     if (is_real_vertex(vh_current.to)) {
                         const auto& v_to = real_vertex(vh_current.to);
-                        t_indicator[v_to] = -1; // "Left"
+                        ws.indicator_at(v_to) = -1; // "Left"
                     }
                     vh_current = vh_current.rotated_cw();
                 }
@@ -58,7 +102,7 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
                 while (vh_current != vh_start) {
                     if (is_real_vertex(vh_current.to)) {
                         const auto& v_to = real_vertex(vh_current.to);
-                        t_indicator[v_to] = 1; // "Right"
+                        ws.indicator_at(v_to) = 1; // "Right"
                     }
                     vh_current = vh_current.rotated_cw();
                 }
@@ -93,8 +137,8 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
             }
 
             LE_ASSERT(he.is_valid());
-            t_indicator[he.vertex_from()] = -1; // "Left"
-            t_indicator[he.vertex_to()] = 1; // "Right"
+            ws.indicator_at(he.vertex_from()) = -1; // "Left"
+            ws.indicator_at(he.vertex_to()) = 1; // "Right"
         }
     }
 
@@ -111,7 +155,6 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
         }
     };
 
-    pm::vertex_attribute<double> distance(t_m, std::numeric_limits<double>::infinity());
     std::priority_queue<Candidate> q;
     std::vector<pm::vertex_handle> t_seed_vertices;
     const auto& l_f = _l_he.face();
@@ -121,7 +164,7 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
         }
         const auto t_v = _em.matching_target_vertex(l_v);
         t_seed_vertices.push_back(t_v);
-        distance[t_v] = 0.0;
+        ws.distance_at(t_v) = 0.0;
         q.push({0.0, t_v});
     }
 
@@ -129,20 +172,26 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
         const auto c = q.top();
         q.pop();
 
-        if (t_indicator[c.v] == -1) {
+        // Stop at the first marked vertex that is settled
+        if (ws.indicator_at(c.v) == -1) {
             // We arrived on the correct (left) side of the path. Probably no spiral.
             return false;
         }
-        else if (t_indicator[c.v] == 1) {
+        else if (ws.indicator_at(c.v) == 1) {
             // We arrived on the wrong (right) side of the path. Spiral detected.
             return true;
         }
 
+        // Skip outdated queue entries
+        if (c.distance > ws.distance_at(c.v)) {
+            continue;
+        }
+
         for (const auto he : c.v.outgoing_halfedges()) {
             const auto& v_to = he.vertex_to();
-            const double new_distance = distance[c.v] + tg::distance(t_pos[c.v], t_pos[v_to]);
-            if (new_distance < distance[v_to]) {
-                distance[v_to] = new_distance;
+            const double new_distance = c.distance + tg::distance(t_pos[c.v], t_pos[v_to]);
+            if (new_distance < ws.distance_at(v_to)) {
+                ws.distance_at(v_to) = new_distance;
                 q.push({new_distance, v_to});
             }
         }
@@ -151,7 +200,7 @@ bool swirl_detection(Embedding& _em, const pm::halfedge_handle& _l_he, const Vir
     return false;
 }
 
-bool swirl_detection_bidirectional(Embedding& _em, const pm::halfedge_handle& _l_he, const VirtualPath& _path)
+bool swirl_detection_bidirectional(const Embedding& _em, const pm::halfedge_handle& _l_he, const VirtualPath& _path)
 {
     if (swirl_detection(_em, _l_he, _path)) {
         return true;
@@ -164,6 +213,41 @@ bool swirl_detection_bidirectional(Embedding& _em, const pm::halfedge_handle& _l
     }
 }
 
+/// Layout vertices of the layout faces reachable from the face of _l_h_seed without crossing embedded layout edges.
+/// _l_e_extra (if valid) is treated as embedded as well.
+std::set<pm::vertex_index> layout_vertices_in_region(const Embedding& _em, const pm::halfedge_handle& _l_h_seed, const pm::edge_handle& _l_e_extra = pm::edge_handle::invalid)
+{
+    std::set<pm::vertex_index> l_vertices;
+
+    std::queue<pm::halfedge_handle> queue;
+    queue.push(_l_h_seed);
+
+    auto visited = _em.layout_mesh().faces().make_attribute<bool>(false);
+    while (!queue.empty()) {
+        const auto h = queue.front();
+        const auto f = h.face();
+        queue.pop();
+
+        if (visited[f])
+            continue;
+        visited[f] = true;
+
+        // Collect layout vertices
+        for (auto l_v : f.vertices())
+            l_vertices.insert(l_v.idx);
+
+        // Enqueue neighbors
+        for (auto l_h_f : f.halfedges()) {
+            const auto l_h_opp = l_h_f.opposite();
+            if (!_em.is_embedded(l_h_opp) && l_h_opp.edge() != _l_e_extra && !visited[l_h_opp.face()]) {
+                queue.push(l_h_opp);
+            }
+        }
+    }
+
+    return l_vertices;
+}
+
 /// [Kraevoy2003] / [Kraevoy2004] blocking condition.
 /// _l_h_seed is already (temporarily) embedded.
 bool is_blocking(const Embedding& _em, const pm::halfedge_handle& _l_h_seed)
@@ -172,69 +256,273 @@ bool is_blocking(const Embedding& _em, const pm::halfedge_handle& _l_h_seed)
 
     // Find sets of layout vertices in patch defined by _l_h.
     // Both in layout and target mesh.
-    std::set<pm::vertex_index> l_vertices;
+    const std::set<pm::vertex_index> l_vertices = layout_vertices_in_region(_em, _l_h_seed);
     std::set<pm::vertex_index> t_vertices;
 
-    { // Collect vertices in layout
-        std::queue<pm::halfedge_handle> queue;
-        queue.push(_l_h_seed);
+    { // Collect vertices in target mesh
+        for (auto t_f : _em.get_region(_em.get_embedded_target_halfedge(_l_h_seed))) {
+            // Collect layout vertices
+            for (auto t_v : t_f.vertices()) {
+                const auto l_v = _em.matching_layout_vertex(t_v);
+                if (l_v.is_valid())
+                    t_vertices.insert(l_v.idx);
+            }
+        }
+    }
 
-        auto visited = _em.layout_mesh().faces().make_attribute<bool>(false);
-        while (!queue.empty()) {
-            const auto h = queue.front();
-            const auto f = h.face();
-            queue.pop();
+    return l_vertices != t_vertices;
+}
 
-            if (visited[f])
-                continue;
-            visited[f] = true;
+/// Splitting of the target faces that a VirtualPath runs through, without actually splitting them.
+///
+/// A path step between an edge midpoint and a vertex or another edge midpoint cuts a face into two pieces.
+/// Each corner of such a face lies on one side of the cut (0 or 1), or on the cut itself (-1).
+/// Pieces are addressed by 2 * face index + side. Faces that are not cut consist of a single piece (side 0).
+/// Path steps along an edge cut no face, they block the edge instead.
+struct PathOverlay
+{
+    struct CutFace
+    {
+        std::array<pm::vertex_handle, 3> corners;
+        std::array<int, 3> sides;
+    };
 
-            // Collect layout vertices
-            for (auto l_v : f.vertices())
-                l_vertices.insert(l_v.idx);
-
-            // Enqueue neighbors
-            for (auto l_h_f : f.halfedges()) {
-                const auto l_h_opp = l_h_f.opposite();
-                if (!_em.is_embedded(l_h_opp) && !visited[l_h_opp.face()]) {
-                    queue.push(l_h_opp);
+    std::unordered_map<int, CutFace> cut_faces; // By face index
+    std::unordered_set<int> cut_edges; // Edges whose midpoint lies on the path
+    std::unordered_set<int> path_edges; // Edges the path runs along
+
+    /// Returns false if the path cuts a face more than once (not supported).
+    bool build(const Embedding& _em, const VirtualPath& _path)
+    {
+        const pm::Mesh& t_m = _em.target_mesh();
+
+        auto add_cut = [&] (const pm::face_handle& _t_f, const std::array<int, 3>& _sides_by_vertex_idx, const std::array<pm::vertex_handle, 3>& _vertices) {
+            CutFace cut;
+            int i = 0;
+            for (const auto t_v : _t_f.vertices()) {
+                cut.corners[i] = t_v;
+                for (int j = 0; j < 3; ++j) {
+                    if (_vertices[j] == t_v) {
+                        cut.sides[i] = _sides_by_vertex_idx[j];
+                    }
+                }
+                ++i;
+            }
+            return cut_faces.emplace(_t_f.idx.value, cut).second;
+        };
+
+        for (int i = 0; i < (int)_path.size(); ++i) {
+            if (is_real_edge(_path[i])) {
+                cut_edges.insert(real_edge(_path[i], t_m).idx.value);
+            }
+        }
+
+        for (int i = 0; i + 1 < (int)_path.size(); ++i) {
+            const auto& vv_a = _path[i];
+            const auto& vv_b = _path[i + 1];
+            if (is_real_vertex(vv_a) && is_real_vertex(vv_b)) {
+                const auto t_h = pm::halfedge_from_to(real_vertex(vv_a, t_m), real_vertex(vv_b, t_m));
+                LE_ASSERT(t_h.is_valid());
+                path_edges.insert(t_h.edge().idx.value);
+            }
+            else if (is_real_vertex(vv_a) != is_real_vertex(vv_b)) {
+                // Cut from a corner to the midpoint of the opposite edge
+                const auto t_v = real_vertex(is_real_vertex(vv_a) ? vv_a : vv_b, t_m);
+                const auto t_e = real_edge(is_real_vertex(vv_a) ? vv_b : vv_a, t_m);
+                auto t_h = t_e.halfedgeA();
+                if (t_h.next().vertex_to() != t_v) {
+                    t_h = t_e.halfedgeB();
+                }
+                LE_ASSERT(t_h.next().vertex_to() == t_v);
+                if (!add_cut(t_h.face(), { -1, 0, 1 }, { t_v, t_h.vertex_from(), t_h.vertex_to() })) {
+                    return false;
+                }
+            }
+            else {
+                // Cut between the midpoints of two edges, separating their common corner
+                const auto t_e_a = real_edge(vv_a, t_m);
+                const auto t_e_b = real_edge(vv_b, t_m);
+                const auto t_f = common_face(t_e_a, t_e_b);
+                const auto t_v_common = common_vertex(t_e_a, t_e_b);
+                LE_ASSERT(t_f.is_valid());
+                LE_ASSERT(t_v_common.is_valid());
+                const auto t_v_a = (t_e_a.vertexA() == t_v_common) ? t_e_a.vertexB() : t_e_a.vertexA();
+                const auto t_v_b = (t_e_b.vertexA() == t_v_common) ? t_e_b.vertexB() : t_e_b.vertexA();
+                if (!add_cut(t_f, { 0, 1, 1 }, { t_v_common, t_v_a, t_v_b })) {
+                    return false;
                 }
             }
         }
+
+        return true;
     }
 
-    { // Collect vertices in target mesh
-        std::queue<pm::halfedge_handle> queue;
-        queue.push(_em.get_embedded_target_halfedge(_l_h_seed));
+    /// Side of the corner _t_v in face _t_f. -1 if it lies on the cut.
+    int side(const pm::face_handle& _t_f, const pm::vertex_handle& _t_v) const
+    {
+        const auto it = cut_faces.find(_t_f.idx.value);
+        if (it == cut_faces.end()) {
+            return 0;
+        }
+        for (int i = 0; i < 3; ++i) {
+            if (it->second.corners[i] == _t_v) {
+                return it->second.sides[i];
+            }
+        }
+        LE_ERROR_THROW("Vertex is not a corner of the face.");
+    }
 
-        auto visited = _em.target_mesh().faces().make_attribute<bool>(false);
-        while (!queue.empty()) {
-            const auto h = queue.front();
-            const auto f = h.face();
-            queue.pop();
+    /// Piece of face _t_f containing the (whole) edge from _t_v_a to _t_v_b.
+    int piece(const pm::face_handle& _t_f, const pm::vertex_handle& _t_v_a, const pm::vertex_handle& _t_v_b) const
+    {
+        const int side_a = side(_t_f, _t_v_a);
+        return 2 * _t_f.idx.value + (side_a >= 0 ? side_a : side(_t_f, _t_v_b));
+    }
 
-            if (visited[f])
+    /// Appends the pieces adjacent to _piece that are not separated from it by an embedded path or the new path.
+    void neighbors(const Embedding& _em, const int _piece, std::vector<int>& _out) const
+    {
+        const auto t_f = _em.target_mesh()[pm::face_index(_piece / 2)];
+        const int s = _piece % 2;
+        for (const auto t_h : t_f.halfedges()) {
+            const auto t_e = t_h.edge();
+            const auto t_f_opp = t_h.opposite_face();
+            if (t_f_opp.is_invalid() || _em.is_blocked(t_e) || path_edges.count(t_e.idx.value)) {
                 continue;
-            visited[f] = true;
+            }
+            const auto t_v_a = t_h.vertex_from();
+            const auto t_v_b = t_h.vertex_to();
+            if (cut_edges.count(t_e.idx.value)) {
+                // Each half of the edge belongs to the piece of its endpoint
+                for (const auto t_v : { t_v_a, t_v_b }) {
+                    if (side(t_f, t_v) == s) {
+                        _out.push_back(2 * t_f_opp.idx.value + side(t_f_opp, t_v));
+                    }
+                }
+            }
+            else if (piece(t_f, t_v_a, t_v_b) == _piece) {
+                _out.push_back(piece(t_f_opp, t_v_a, t_v_b));
+            }
+        }
+    }
 
-            // Collect layout vertices
-            for (auto t_v : f.vertices()) {
+    /// Collects the layout vertices matched to corners of the piece (including corners on the cut).
+    void collect_layout_vertices(const Embedding& _em, const int _piece, std::set<pm::vertex_index>& _l_vertices) const
+    {
+        const auto t_f = _em.target_mesh()[pm::face_index(_piece / 2)];
+        for (const auto t_v : t_f.vertices()) {
+            const int s = side(t_f, t_v);
+            if (s == -1 || s == _piece % 2) {
                 const auto l_v = _em.matching_layout_vertex(t_v);
                 if (l_v.is_valid())
-                    t_vertices.insert(l_v.idx);
+                    _l_vertices.insert(l_v.idx);
             }
+        }
+    }
+
+    /// Pieces of a face
+    int num_pieces(const pm::face_handle& _t_f) const
+    {
+        return cut_faces.count(_t_f.idx.value) ? 2 : 1;
+    }
+};
 
-            // Enqueue neighbors
-            for (auto t_h_f : f.halfedges()) {
-                const auto t_h_opp = t_h_f.opposite();
-                if (!_em.is_blocked(t_h_opp.edge()) && !visited[t_h_opp.face()]) {
-                    queue.push(t_h_opp);
+/// Same as the copy-based blocking test below, but evaluated on an overlay of the path
+/// over the current face regions, without splitting target edges.
+/// Returns std::nullopt if the overlay does not support the path.
+std::optional<bool> is_blocking_overlay(const Embedding& _em, const pm::edge_handle& _l_e, const VirtualPath& _path)
+{
+    LE_ASSERT_GEQ(_path.size(), 2);
+    const pm::Mesh& t_m = _em.target_mesh();
+
+    PathOverlay overlay;
+    if (!overlay.build(_em, _path)) {
+        return std::nullopt;
+    }
+
+    // Pieces left (0) and right (1) of the first path step
+    int start_piece[2];
+    const auto t_v_start = real_vertex(_path[0], t_m);
+    if (is_real_vertex(_path[1])) {
+        const auto t_h = pm::halfedge_from_to(t_v_start, real_vertex(_path[1], t_m));
+        if (t_h.face().is_invalid() || t_h.opposite_face().is_invalid()) {
+            return std::nullopt;
+        }
+        start_piece[0] = overlay.piece(t_h.face(), t_h.vertex_from(), t_h.vertex_to());
+        start_piece[1] = overlay.piece(t_h.opposite_face(), t_h.vertex_from(), t_h.vertex_to());
+    }
+    else {
+        // Cut from the start vertex to the midpoint of the opposite edge t_h.
+        // Faces are oriented counterclockwise, so (looking from the start vertex) t_h runs from right to left.
+        const auto t_e = real_edge(_path[1], t_m);
+        auto t_h = t_e.halfedgeA();
+        if (t_h.next().vertex_to() != t_v_start) {
+            t_h = t_e.halfedgeB();
+        }
+        const auto t_f = t_h.face();
+        start_piece[0] = 2 * t_f.idx.value + overlay.side(t_f, t_h.vertex_to());
+        start_piece[1] = 2 * t_f.idx.value + overlay.side(t_f, t_h.vertex_from());
+    }
+    const int region = _em.face_regions().region(t_m[pm::face_index(start_piece[0] / 2)]);
+
+    // Flood fill from both sides in lockstep, until they meet (the path does not split its region)
+    // or one side runs out of pieces (it is cut off).
+    std::unordered_set<int> visited[2] = { { start_piece[0] }, { start_piece[1] } };
+    std::vector<int> side[2] = { { start_piece[0] }, { start_piece[1] } };
+    int head[2] = { 0, 0 };
+    int cut_off = -1;
+    std::vector<int> adjacent;
+    while (cut_off < 0) {
+        bool met = false;
+        for (int s = 0; s < 2 && !met; ++s) {
+            if (head[s] == (int)side[s].size()) {
+                cut_off = s;
+                break;
+            }
+            adjacent.clear();
+            overlay.neighbors(_em, side[s][head[s]++], adjacent);
+            for (const int p : adjacent) {
+                if (visited[1 - s].count(p)) {
+                    met = true;
+                    break;
+                }
+                if (visited[s].insert(p).second) {
+                    side[s].push_back(p);
                 }
             }
         }
+        if (met) {
+            break;
+        }
     }
 
-    return l_vertices != t_vertices;
+    std::set<pm::vertex_index> t_vertices[2];
+    if (cut_off < 0) {
+        // Region stays connected. Both sides see all of it.
+        for (const auto t_f : _em.face_regions().faces(t_m, region)) {
+            for (int s = 0; s < overlay.num_pieces(t_f); ++s) {
+                overlay.collect_layout_vertices(_em, 2 * t_f.idx.value + s, t_vertices[0]);
+            }
+        }
+        t_vertices[1] = t_vertices[0];
+    }
+    else {
+        // The cut off side was enumerated completely, the other side is the rest of the region
+        for (const int p : side[cut_off]) {
+            overlay.collect_layout_vertices(_em, p, t_vertices[cut_off]);
+        }
+        for (const auto t_f : _em.face_regions().faces(t_m, region)) {
+            for (int s = 0; s < overlay.num_pieces(t_f); ++s) {
+                const int p = 2 * t_f.idx.value + s;
+                if (!visited[cut_off].count(p)) {
+                    overlay.collect_layout_vertices(_em, p, t_vertices[1 - cut_off]);
+                }
+            }
+        }
+    }
+
+    return layout_vertices_in_region(_em, _l_e.halfedgeA(), _l_e) != t_vertices[0]
+        || layout_vertices_in_region(_em, _l_e.halfedgeB(), _l_e) != t_vertices[1];
 }
 
 /// [Kraevoy2003] / [Kraevoy2004] blocking condition.
@@ -244,6 +532,10 @@ bool is_blocking(const Embedding& _em, const pm::edge_handle& _l_e, const Virtua
 {
     LE_ASSERT(!_em.is_embedded(_l_e));
 
+    if (const auto blocking = is_blocking_overlay(_em, _l_e, _path)) {
+        return *blocking;
+    }
+
     // Copy embedding to temporarily embed the path
     Embedding em_copy = _em;
     em_copy.embed_path(_l_e.halfedgeA(), _path);
@@ -251,10 +543,113 @@ bool is_blocking(const Embedding& _em, const pm::edge_handle& _l_e, const Virtua
     return is_blocking(em_copy, _l_e.halfedgeA()) || is_blocking(em_copy, _l_e.halfedgeB());
 }
 
+/// Path search result for a layout edge, reused across iterations of embed_greedy.
+struct CachedPath
+{
+    bool valid = false;
+    VirtualPath path;
+    double cost = std::numeric_limits<double>::infinity();
+};
+
+/// Region of the sector in which the layout halfedge _l_he would start. -1 if unknown.
+int sector_region(const Embedding& _em, const pm::halfedge_handle& _l_he)
+{
+    const auto t_f = _em.get_embeddable_sector(_l_he).face();
+    if (t_f.is_invalid()) {
+        return -1;
+    }
+    return _em.face_regions().region(t_f);
+}
+
+/// Drops the cached paths that might be found differently after _l_e_embedded has been embedded.
+///
+/// Embedding a path only changes the search graph nodes in the faces around it (splits, blocked flags).
+/// A search can only be affected if it expands such a node or one of its neighbors, i.e. an element of a face
+/// around a vertex of a face around the path ("dirty" elements). A cached path is kept if either
+/// - its search ran in another region than the new path (_other_region) and neither endpoint is dirty,
+///   since the search never leaves its region, or
+/// - the geodesic metric is used and no dirty element lies within the ellipsoid around the two endpoints
+///   whose radii sum is the path length, since A* with the Euclidean heuristic only expands nodes in there.
+void invalidate_cached_paths(
+        const Embedding& _em,
+        const pm::edge_handle& _l_e_embedded,
+        const bool _geodesic,
+        const std::vector<char>& _other_region,
+        std::vector<CachedPath>& _cache)
+{
+    _cache[_l_e_embedded.idx.value] = CachedPath();
+
+    const auto& t_pos = _em.target_pos();
+    std::unordered_set<int> t_v_ring;
+    for (const auto t_v : _em.get_embedded_path(_l_e_embedded.halfedgeA())) {
+        for (const auto t_f : t_v.faces()) {
+            if (t_f.is_valid()) {
+                for (const auto t_v_f : t_f.vertices()) {
+                    t_v_ring.insert(t_v_f.idx.value);
+                }
+            }
+        }
+    }
+
+    std::unordered_set<int> t_f_dirty;
+    std::unordered_set<int> t_v_dirty;
+    std::unordered_set<int> t_e_dirty;
+    std::vector<tg::pos3> p_dirty;
+    for (const int i : t_v_ring) {
+        for (const auto t_f : _em.target_mesh()[pm::vertex_index(i)].faces()) {
+            if (t_f.is_invalid() || !t_f_dirty.insert(t_f.idx.value).second) {
+                continue;
+            }
+            for (const auto t_h : t_f.halfedges()) {
+                if (t_v_dirty.insert(t_h.vertex_to().idx.value).second) {
+                    p_dirty.push_back(_em.element_pos(t_h.vertex_to()));
+                }
+                if (t_e_dirty.insert(t_h.edge().idx.value).second) {
+                    p_dirty.push_back(_em.element_pos(t_h.edge()));
+                }
+            }
+        }
+    }
+
+    for (const auto l_e : _em.layout_mesh().edges()) {
+        auto& cached = _cache[l_e.idx.value];
+        if (!cached.valid) {
+            continue;
+        }
+
+        const auto t_v_a = _em.matching_target_vertex(l_e.vertexA());
+        const auto t_v_b = _em.matching_target_vertex(l_e.vertexB());
+        const bool endpoints_clean = !t_v_dirty.count(t_v_a.idx.value) && !t_v_dirty.count(t_v_b.idx.value);
+        if (_other_region[l_e.idx.value] && endpoints_clean) {
+            continue;
+        }
+
+        if (_geodesic) {
+            // Slack for the single precision arc lengths of the search graph
+            const double bound = cached.cost * (1.0 + 1e-5);
+            bool ellipsoid_clean = true;
+            for (const auto& p : p_dirty) {
+                if (tg::distance(t_pos[t_v_a], p) + tg::distance(p, t_pos[t_v_b]) <= bound) {
+                    ellipsoid_clean = false;
+                    break;
+                }
+            }
+            if (ellipsoid_clean) {
+                continue;
+            }
+        }
+
+        cached = CachedPath();
+    }
+}
+
 }
 
 GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const std::string& _name)
 {
+    LE_PROFILE_ONLY(const Profile profile_before = thread_profile();)
+    LE_PROFILE_NAMED_SCOPE(greedy_scope, "embed_greedy");
+
     GreedyResult result(_name, _settings);
 
     // If vertex-repulsive tracing is enabled, copy input embedding.
@@ -313,6 +708,15 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
 
     UnionFind l_v_components(l_m.vertices().size());
 
+    auto metric = Embedding::ShortestPathMetric::Geodesic;
+    if (_settings.use_vertex_repulsive_tracing) {
+        metric = Embedding::ShortestPathMetric::VertexRepulsive;
+    }
+
+    // Per layout edge
+    std::vector<CachedPath> cached_paths(l_num_edges);
+    std::vector<char> l_other_region(l_num_edges, false);
+
     while (l_num_embedded_edges < l_num_edges) {
         VirtualPath best_path;
         double best_path_cost = std::numeric_limits<double>::infinity();
@@ -336,18 +740,24 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
                 }
             }
 
-            auto metric = Embedding::ShortestPathMetric::Geodesic;
-            if (_settings.use_vertex_repulsive_tracing) {
-                metric = Embedding::ShortestPathMetric::VertexRepulsive;
+            auto& cached = cached_paths[l_e.idx.value];
+            if (!cached.valid) {
+                cached.path = _em.find_shortest_path(l_e.halfedgeA(), metric);
+                cached.cost = _em.path_length(cached.path);
+                cached.valid = _settings.cache_paths;
+                LE_PROFILE_COUNT("path_cache_misses", 1);
             }
-
-            VirtualPath path = _em.find_shortest_path(l_e.halfedgeA(), metric);
-            double path_cost = _em.path_length(path);
+            else {
+                LE_PROFILE_COUNT("path_cache_hits", 1);
+            }
+            VirtualPath path = cached.path;
+            double path_cost = cached.cost;
 
             // If we use the blocking condition, we have to discard the path if
             // the vertices enclosed in new patches differ between the layout and the embedding.
             if (_settings.use_blocking_condition) {
                 if (l_v_components.equivalent(l_vi_a, l_vi_b)) {
+                    LE_PROFILE_SCOPE("blocking_test");
                     if (is_blocking(_em, l_e, path)) {
                         continue;
                     }
@@ -365,6 +775,7 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
             if (_settings.use_swirl_detection) {
                 // Only do the swirl test if the current path is already a contender.
                 if (path_cost < best_path_cost) {
+                    LE_PROFILE_SCOPE("swirl_test");
                     if (swirl_detection_bidirectional(_em, l_e.halfedgeA(), path)) {
                         path_cost *= _settings.swirl_penalty_factor;
                     }
@@ -380,8 +791,24 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
             }
         }
 
+        // Regions are about to change. Remember which cached searches ran in another region.
+        if (_settings.cache_paths) {
+            const int r_best = sector_region(_em, best_l_e.halfedgeA());
+            for (const auto l_e : l_m.edges()) {
+                if (cached_paths[l_e.idx.value].valid && l_e != best_l_e) {
+                    const int r = sector_region(_em, l_e.halfedgeA());
+                    l_other_region[l_e.idx.value] = (r >= 0) && (r_best >= 0) && (r != r_best);
+                }
+            }
+        }
+
         result.insertion_sequence.push_back(best_l_e);
         _em.embed_path(best_l_e.halfedgeA(), best_path);
+
+        if (_settings.cache_paths) {
+            LE_PROFILE_SCOPE("invalidate_cached_paths");
+            invalidate_cached_paths(_em, best_l_e, metric == Embedding::ShortestPathMetric::Geodesic, l_other_region, cached_paths);
+        }
         l_v_components.merge(best_l_e.vertexA().idx.value, best_l_e.vertexB().idx.value);
         l_is_embedded[best_l_e] = true;
         ++l_num_embedded_edges;
@@ -390,6 +817,7 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
     // If vertex-repulsive tracing was used,
     // re-trace the insertion sequence as shortest paths
     if (_settings.use_vertex_repulsive_tracing) {
+        LE_PROFILE_SCOPE("retrace");
         LE_ASSERT(em_copy);
         for (auto l_e_idx : result.insertion_sequence) {
             const auto l_h = em_copy.value().layout_mesh().edges()[l_e_idx].halfedgeA();
@@ -402,6 +830,9 @@ GreedyResult embed_greedy(Embedding& _em, const GreedySettings& _settings, const
     LE_ASSERT(_em.is_complete());
     result.cost = _em.total_embedded_path_length();
 
+    LE_PROFILE_STOP(greedy_scope);
+    LE_PROFILE_ONLY(result.profile = thread_profile() - profile_before;)
+
     return result;
 }
 
@@ -2,6 +2,7 @@
 
 #include <LayoutEmbedding/Embedding.hh>
 #include <LayoutEmbedding/InsertionSequence.hh>
+#include <LayoutEmbedding/Util/Profiling.hh>
 
 namespace LayoutEmbedding {
 
@@ -27,6 +28,10 @@ struct GreedySettings
     // Prefer insertion of edges that connect extremal vertices (with large average distance to neighbors) [Schreiner2004]
     bool prefer_extremal_vertices = false;
     double extremal_vertex_ratio = 0.25;
+
+    // Reuse the paths found in previous iterations as long as the newly embedded paths cannot have changed them.
+    // Does not change the result.
+    bool cache_paths = true;
 };
 
 struct GreedyResult
@@ -40,6 +45,8 @@ struct GreedyResult
     GreedySettings settings;
     InsertionSequence insertion_sequence;
     double cost = std::numeric_limits<double>::infinity();
+
+    Profile profile; // Per-phase breakdown. Empty unless built with LE_ENABLE_PROFILING.
 };
 
 // Run a single greedy variant
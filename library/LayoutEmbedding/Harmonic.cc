@@ -1,7 +1,9 @@
 #include "Harmonic.hh"
 
 #include <LayoutEmbedding/Util/Assert.hh>
-#include <Eigen/SparseLU>
+#include <LayoutEmbedding/Util/Profiling.hh>
+
+#include <algorithm>
 
 namespace LayoutEmbedding
 {
@@ -39,72 +41,280 @@ double mean_value_weight(
 
 }
 
-bool harmonic(
+bool HarmonicSolver::Pattern::matches(const Eigen::SparseMatrix<double>& _A) const
+{
+    LE_ASSERT(_A.isCompressed());
+    if ((int)outer.size() != _A.outerSize() + 1 || (int)inner.size() != _A.nonZeros())
+        return false;
+
+    return std::equal(outer.begin(), outer.end(), _A.outerIndexPtr())
+        && std::equal(inner.begin(), inner.end(), _A.innerIndexPtr());
+}
+
+void HarmonicSolver::Pattern::assign(const Eigen::SparseMatrix<double>& _A)
+{
+    LE_ASSERT(_A.isCompressed());
+    outer.assign(_A.outerIndexPtr(), _A.outerIndexPtr() + _A.outerSize() + 1);
+    inner.assign(_A.innerIndexPtr(), _A.innerIndexPtr() + _A.nonZeros());
+}
+
+void HarmonicSolver::setup(
         const pm::vertex_attribute<tg::pos3>& _pos,
         const pm::vertex_attribute<bool>& _constrained,
-        const Eigen::MatrixXd& _constraint_values,
-        Eigen::MatrixXd& _res,
-        const LaplaceWeights _weights,
-        const bool _fallback_iterative)
+        const LaplaceWeights _weights)
 {
+    LE_PROFILE_SCOPE("setup");
     LE_ASSERT(_pos.mesh().is_compact());
 
-    const int n = _pos.mesh().vertices().size();
-    const int d = _constraint_values.cols();
-    LE_ASSERT_EQ(_constraint_values.rows(), n);
+    factorized = false;
+    n = _pos.mesh().vertices().size();
+
+    // Enumerate free vertices
+    reduced_index.assign(n, -1);
+    full_index.clear();
+    for (auto v : _pos.mesh().vertices())
+    {
+        if (!_constrained[v])
+        {
+            reduced_index[v.idx.value] = full_index.size();
+            full_index.push_back(v.idx.value);
+        }
+    }
+    const int n_free = full_index.size();
 
-    // Set up Laplace matrix and rhs
-    Eigen::MatrixXd rhs = Eigen::MatrixXd::Zero(n, d);
-    std::vector<Eigen::Triplet<double>> triplets;
+    // Set up reduced system
+    std::vector<Eigen::Triplet<double>> triplets_A;
+    std::vector<Eigen::Triplet<double>> triplets_B;
     for (auto v : _pos.mesh().vertices())
     {
-        const int i = v.idx.value;
+        const int i = reduced_index[v.idx.value];
+        if (i < 0)
+            continue;
 
-        if (_constrained[v])
+        LE_ASSERT(!v.is_boundary());
+
+        for (auto h : v.outgoing_halfedges())
         {
-            triplets.push_back(Eigen::Triplet<double>(i, i, 1.0));
-            rhs.row(i) = _constraint_values.row(i);
+            double w_ij;
+            if (_weights == LaplaceWeights::Uniform)
+                w_ij = 1.0;
+            else if (_weights == LaplaceWeights::MeanValue)
+                w_ij = mean_value_weight(_pos, h);
+            else
+                LE_ERROR_THROW("");
+
+            triplets_A.push_back(Eigen::Triplet<double>(i, i, w_ij));
+
+            const int j_full = h.vertex_to().idx.value;
+            const int j = reduced_index[j_full];
+            if (j >= 0)
+                triplets_A.push_back(Eigen::Triplet<double>(i, j, -w_ij));
+            else
+                triplets_B.push_back(Eigen::Triplet<double>(i, j_full, w_ij));
+        }
+    }
+
+    A.resize(n_free, n_free);
+    A.setFromTriplets(triplets_A.begin(), triplets_A.end());
+    A.makeCompressed();
+    B.resize(n_free, n);
+    B.setFromTriplets(triplets_B.begin(), triplets_B.end());
+
+    symmetric = (_weights == LaplaceWeights::Uniform);
+}
+
+bool HarmonicSolver::factorize()
+{
+    LE_PROFILE_SCOPE("factorize");
+    factorized = false;
+
+    if (full_index.empty())
+    {
+        factorized = true;
+        return true;
+    }
+
+    if (symmetric)
+    {
+        if (!ldlt_pattern.matches(A))
+        {
+            ldlt.analyzePattern(A);
+            ldlt_pattern.assign(A);
+        }
+        else
+        {
+            LE_PROFILE_COUNT("symbolic_reuses", 1);
+        }
+        ldlt.factorize(A);
+        factorized = (ldlt.info() == Eigen::Success);
+    }
+    else
+    {
+        if (!lu_pattern.matches(A))
+        {
+            lu.analyzePattern(A);
+            lu_pattern.assign(A);
         }
         else
         {
-            LE_ASSERT(!v.is_boundary());
-
-            for (auto h : v.outgoing_halfedges())
-            {
-                const int j = h.vertex_to().idx.value;
-                double w_ij;
-                if (_weights == LaplaceWeights::Uniform)
-                    w_ij = 1.0;
-                else if (_weights == LaplaceWeights::MeanValue)
-                    w_ij = mean_value_weight(_pos, h);
-                else
-                    LE_ERROR_THROW("");
-
-                triplets.push_back(Eigen::Triplet<double>(i, j, w_ij));
-                triplets.push_back(Eigen::Triplet<double>(i, i, -w_ij));
-            }
+            LE_PROFILE_COUNT("symbolic_reuses", 1);
         }
+        lu.factorize(A);
+        factorized = (lu.info() == Eigen::Success);
     }
 
-    Eigen::SparseMatrix<double> L(n, n);
-    L.setFromTriplets(triplets.begin(), triplets.end());
+    return factorized;
+}
 
-    Eigen::SparseLU<Eigen::SparseMatrix<double>> solver;
-    solver.compute(L);
-    if (solver.info() == Eigen::Success)
+bool HarmonicSolver::factorize(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const LaplaceWeights _weights)
+{
+    setup(_pos, _constrained, _weights);
+    return factorize();
+}
+
+bool HarmonicSolver::solve(
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res) const
+{
+    LE_PROFILE_SCOPE("solve");
+    LE_ASSERT(factorized);
+    LE_ASSERT_EQ(_constraint_values.rows(), n);
+
+    const Eigen::MatrixXd rhs = B * _constraint_values;
+    Eigen::MatrixXd x;
+    if (full_index.empty())
     {
-        _res = solver.solve(rhs);
-        if (solver.info() == Eigen::Success)
-            return true;
+        x.resize(0, _constraint_values.cols());
+    }
+    else if (symmetric)
+    {
+        x = ldlt.solve(rhs);
+        if (ldlt.info() != Eigen::Success)
+            return false;
+    }
+    else
+    {
+        x = lu.solve(rhs);
+        if (lu.info() != Eigen::Success)
+            return false;
+    }
+
+    scatter(x, _constraint_values, _res);
+    return true;
+}
+
+bool HarmonicSolver::solve_iterative(
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res,
+        const Eigen::MatrixXd* _initial_guess) const
+{
+    LE_PROFILE_SCOPE("solve_iterative");
+    LE_ASSERT_EQ(_constraint_values.rows(), n);
+
+    const Eigen::MatrixXd rhs = B * _constraint_values;
+
+    // Gather initial guess
+    Eigen::MatrixXd x0 = Eigen::MatrixXd::Zero(full_index.size(), _constraint_values.cols());
+    if (_initial_guess)
+    {
+        LE_ASSERT_EQ(_initial_guess->rows(), n);
+        LE_ASSERT_EQ(_initial_guess->cols(), _constraint_values.cols());
+        for (int i = 0; i < (int)full_index.size(); ++i)
+            x0.row(i) = _initial_guess->row(full_index[i]);
+    }
+
+    const double tolerance = 1e-10;
+    Eigen::MatrixXd x;
+    if (full_index.empty())
+    {
+        x = x0;
+    }
+    else if (symmetric)
+    {
+        Eigen::ConjugateGradient<Eigen::SparseMatrix<double>, Eigen::Lower | Eigen::Upper, Eigen::IncompleteCholesky<double>> cg;
+        cg.setTolerance(tolerance);
+        cg.compute(A);
+        if (cg.info() != Eigen::Success)
+            return false;
+        x = cg.solveWithGuess(rhs, x0);
+        LE_PROFILE_COUNT("iterations", cg.iterations());
+        if (cg.info() != Eigen::Success)
+            return false;
+    }
+    else
+    {
+        // Small fill factor keeps the preconditioner memory proportional to the system size
+        Eigen::BiCGSTAB<Eigen::SparseMatrix<double>, Eigen::IncompleteLUT<double>> bicgstab;
+        bicgstab.preconditioner().setFillfactor(4);
+        bicgstab.setTolerance(tolerance);
+        bicgstab.compute(A);
+        if (bicgstab.info() != Eigen::Success)
+            return false;
+        x = bicgstab.solveWithGuess(rhs, x0);
+        LE_PROFILE_COUNT("iterations", bicgstab.iterations());
+        if (bicgstab.info() != Eigen::Success)
+            return false;
+    }
+
+    scatter(x, _constraint_values, _res);
+    return true;
+}
+
+int HarmonicSolver::num_free_vertices() const
+{
+    return full_index.size();
+}
+
+void HarmonicSolver::scatter(
+        const Eigen::MatrixXd& _x,
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res) const
+{
+    _res.resize(n, _constraint_values.cols());
+    for (int i = 0; i < n; ++i)
+    {
+        if (reduced_index[i] < 0)
+            _res.row(i) = _constraint_values.row(i);
+        else
+            _res.row(i) = _x.row(reduced_index[i]);
     }
+}
+
+bool harmonic(
+        const pm::vertex_attribute<tg::pos3>& _pos,
+        const pm::vertex_attribute<bool>& _constrained,
+        const Eigen::MatrixXd& _constraint_values,
+        Eigen::MatrixXd& _res,
+        const LaplaceWeights _weights,
+        const bool _fallback_iterative,
+        const Eigen::MatrixXd* _initial_guess,
+        HarmonicSolver* _solver)
+{
+    LE_PROFILE_SCOPE("harmonic");
+    LE_ASSERT_EQ(_constraint_values.rows(), (int)_pos.mesh().vertices().size());
 
-    std::cout << "LU solve failed" << std::endl;
+    HarmonicSolver temporary_solver;
+    HarmonicSolver& solver = _solver ? *_solver : temporary_solver;
+    solver.setup(_pos, _constrained, _weights);
 
-    if (_fallback_iterative)
+    // Large systems are always solved iteratively to keep the memory use bounded
+    if (solver.num_free_vertices() <= harmonic_max_direct_solve_size)
     {
-        std::cout << "Falling back to iterative solver" << std::endl;
+        if (solver.factorize() && solver.solve(_constraint_values, _res))
+            return true;
+
+        LE_PROFILE_COUNT("direct_failures", 1);
+        if (!_fallback_iterative)
+            return false;
     }
 
+    if (solver.solve_iterative(_constraint_values, _res, _initial_guess))
+        return true;
+
+    LE_PROFILE_COUNT("iterative_failures", 1);
     return false;
 }
 
@@ -114,7 +324,9 @@ bool harmonic_parametrization(
         const VertexParam& _constraint_values,
         VertexParam& _res,
         const LaplaceWeights _weights,
-        const bool _fallback_iterative)
+        const bool _fallback_iterative,
+        const VertexParam* _initial_guess,
+        HarmonicSolver* _solver)
 {
     const int n = _pos.mesh().vertices().size();
     const int d = 2;
@@ -124,9 +336,17 @@ bool harmonic_parametrization(
     for (auto v : _pos.mesh().vertices())
         constraint_values.row(v.idx.value) = Eigen::Vector2d(_constraint_values[v].x, _constraint_values[v].y);
 
+    Eigen::MatrixXd initial_guess;
+    if (_initial_guess)
+    {
+        initial_guess = Eigen::MatrixXd::Zero(n, d);
+        for (auto v : _pos.mesh().vertices())
+            initial_guess.row(v.idx.value) = Eigen::Vector2d((*_initial_guess)[v].x, (*_initial_guess)[v].y);
+    }
+
     // Compute
     Eigen::MatrixXd res_mat;
-    if (!harmonic(_pos, _constrained, constraint_values, res_mat, _weights, _fallback_iterative))
+    if (!harmonic(_pos, _constrained, constraint_values, res_mat, _weights, _fallback_iterative, _initial_guess ? &initial_guess : nullptr, _solver))
         return false;
 
     // Convert result
@@ -1,10 +1,16 @@
 #pragma once
 
 #include <Eigen/Dense>
+#include <Eigen/IterativeLinearSolvers>
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+#include <Eigen/SparseLU>
 #include <polymesh/pm.hh>
 #include <typed-geometry/tg.hh>
 #include <LayoutEmbedding/Parametrization.hh>
 
+#include <vector>
+
 namespace LayoutEmbedding
 {
 
@@ -14,6 +20,84 @@ enum class LaplaceWeights
     MeanValue,
 };
 
+/// Above this number of free vertices, harmonic() skips the direct factorization
+/// (whose fill-in grows too large) and solves iteratively right away, independent of _fallback_iterative.
+constexpr int harmonic_max_direct_solve_size = 500000;
+
+/// Solves harmonic problems (Laplace equation with Dirichlet constraints) on a mesh.
+///
+/// Constrained vertices are eliminated, leaving a system A x = B c over the free vertices only,
+/// where A = -L_FF and B = L_FC. With uniform weights, A is symmetric positive definite and factorized via LDLT.
+/// Mean value weights are not symmetric, so A is factorized via LU in that case.
+///
+/// The symbolic analysis of each factorization is kept and reused by subsequent factorizations,
+/// as long as the sparsity pattern of A does not change (e.g. same mesh region and constraints, different weights or positions).
+/// LDLT and LU keep separate analyses, so alternating between uniform and mean value weights reuses both.
+/// Eigen keeps the analysis and the numeric factors in the same object, so a solver kept for reuse also keeps its factors alive.
+/// Only keep solvers across calls if the pattern is likely to repeat (e.g. same region with different weights).
+class HarmonicSolver
+{
+public:
+    /// Sets up the reduced system without factorizing it.
+    void setup(
+            const pm::vertex_attribute<tg::pos3>& _pos,
+            const pm::vertex_attribute<bool>& _constrained,
+            const LaplaceWeights _weights);
+
+    /// Direct factorization of the system that was set up last.
+    bool factorize();
+
+    /// Sets up and factorizes the reduced system.
+    bool factorize(
+            const pm::vertex_attribute<tg::pos3>& _pos,
+            const pm::vertex_attribute<bool>& _constrained,
+            const LaplaceWeights _weights);
+
+    /// Solves the most recently factorized system for (potentially multiple) columns of constraint values.
+    /// _constraint_values and _res have one row per vertex. Rows of free vertices in _constraint_values are ignored.
+    bool solve(
+            const Eigen::MatrixXd& _constraint_values,
+            Eigen::MatrixXd& _res) const;
+
+    /// Solves the system that was set up last iteratively, without factorizing it.
+    /// Uses CG with incomplete Cholesky preconditioning for symmetric systems, BiCGSTAB with incomplete LU otherwise.
+    /// The rows of free vertices in _initial_guess (if given) are used as starting point.
+    bool solve_iterative(
+            const Eigen::MatrixXd& _constraint_values,
+            Eigen::MatrixXd& _res,
+            const Eigen::MatrixXd* _initial_guess = nullptr) const;
+
+    int num_free_vertices() const;
+
+private:
+    struct Pattern
+    {
+        std::vector<int> outer;
+        std::vector<int> inner;
+
+        bool matches(const Eigen::SparseMatrix<double>& _A) const;
+        void assign(const Eigen::SparseMatrix<double>& _A);
+    };
+
+    int n = 0; // Number of vertices
+    std::vector<int> reduced_index; // Per vertex. -1 for constrained vertices.
+    std::vector<int> full_index; // Per free vertex
+
+    Eigen::SparseMatrix<double> A; // Free x free
+    Eigen::SparseMatrix<double> B; // Free x all, only non-zero in columns of constrained vertices
+
+    bool symmetric = false;
+    bool factorized = false;
+
+    void scatter(const Eigen::MatrixXd& _x, const Eigen::MatrixXd& _constraint_values, Eigen::MatrixXd& _res) const;
+
+    Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> ldlt;
+    Pattern ldlt_pattern;
+
+    Eigen::SparseLU<Eigen::SparseMatrix<double>> lu;
+    Pattern lu_pattern;
+};
+
 /// Compute harmonic field using mean-value weights.
 bool harmonic(
         const pm::vertex_attribute<tg::pos3>& _pos,
@@ -21,7 +105,9 @@ bool harmonic(
         const Eigen::MatrixXd& _constraint_values,
         Eigen::MatrixXd& _res,
         const LaplaceWeights _weights,
-        const bool _fallback_iterative = false);
+        const bool _fallback_iterative = false, // Solve iteratively if the direct solve fails
+        const Eigen::MatrixXd* _initial_guess = nullptr, // Warm start for the iterative solver
+        HarmonicSolver* _solver = nullptr); // Reused between calls if given. Otherwise, a temporary solver is used.
 
 /// Compute harmonic field using mean-value weights.
 bool harmonic_parametrization(
@@ -30,6 +116,8 @@ bool harmonic_parametrization(
         const VertexParam& _constraint_values,
         VertexParam& _res,
         const LaplaceWeights _weights,
-        const bool _fallback_iterative = false);
+        const bool _fallback_iterative = false,
+        const VertexParam* _initial_guess = nullptr, // Warm start for the iterative solver
+        HarmonicSolver* _solver = nullptr); // Reused between calls if given. Otherwise, a temporary solver is used.
 
 }
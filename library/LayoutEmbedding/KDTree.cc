@@ -0,0 +1,165 @@
+#include "KDTree.hh"
+
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+#include <queue>
+
+namespace LayoutEmbedding {
+
+namespace
+{
+
+constexpr int max_leaf_size = 8;
+
+}
+
+KDTree::KDTree(const std::vector<tg::pos3>& _points)
+{
+    std::vector<int> ids(_points.size());
+    for (int i = 0; i < (int)ids.size(); ++i) {
+        ids[i] = i;
+    }
+    build(_points, ids);
+}
+
+KDTree::KDTree(const pm::vertex_attribute<tg::pos3>& _pos)
+{
+    std::vector<tg::pos3> points;
+    std::vector<int> ids;
+    for (const auto v : _pos.mesh().vertices()) {
+        points.push_back(_pos[v]);
+        ids.push_back(v.idx.value);
+    }
+    build(points, ids);
+}
+
+void KDTree::build(const std::vector<tg::pos3>& _points, const std::vector<int>& _ids)
+{
+    LE_ASSERT_EQ(_points.size(), _ids.size());
+
+    items.resize(_points.size());
+    for (int i = 0; i < (int)_points.size(); ++i) {
+        items[i] = { _points[i], _ids[i] };
+    }
+
+    nodes.clear();
+    if (!items.empty()) {
+        nodes.reserve(4 * (items.size() / max_leaf_size + 1));
+        nodes.emplace_back();
+        build_node(0, 0, items.size());
+    }
+}
+
+void KDTree::build_node(const int _node, const int _begin, const int _end)
+{
+    nodes[_node].begin = _begin;
+    nodes[_node].end = _end;
+    if (_end - _begin <= max_leaf_size) {
+        return;
+    }
+
+    // Split the widest extent at the median
+    tg::pos3 min = items[_begin].p;
+    tg::pos3 max = items[_begin].p;
+    for (int i = _begin + 1; i < _end; ++i) {
+        for (int d = 0; d < 3; ++d) {
+            min[d] = std::min(min[d], items[i].p[d]);
+            max[d] = std::max(max[d], items[i].p[d]);
+        }
+    }
+    int axis = 0;
+    for (int d = 1; d < 3; ++d) {
+        if (max[d] - min[d] > max[axis] - min[axis]) {
+            axis = d;
+        }
+    }
+
+    const int mid = (_begin + _end) / 2;
+    std::nth_element(items.begin() + _begin, items.begin() + mid, items.begin() + _end, [&] (const Item& a, const Item& b) {
+        return a.p[axis] < b.p[axis];
+    });
+
+    // Children are allocated next to each other
+    const int children = nodes.size();
+    nodes.emplace_back();
+    nodes.emplace_back();
+    nodes[_node].children = children;
+    nodes[_node].axis = axis;
+    nodes[_node].split = items[mid].p[axis];
+
+    build_node(children, _begin, mid);
+    build_node(children + 1, mid, _end);
+}
+
+int KDTree::nearest(const tg::pos3& _p) const
+{
+    return nearest_if(_p, [] (int) { return true; });
+}
+
+std::vector<int> KDTree::k_nearest(const tg::pos3& _p, const int _k) const
+{
+    std::vector<int> result;
+    if (nodes.empty() || _k <= 0) {
+        return result;
+    }
+
+    struct Entry
+    {
+        float dist;
+        int id;
+
+        bool operator<(const Entry& _rhs) const
+        {
+            return closer(dist, id, _rhs.dist, _rhs.id);
+        }
+    };
+
+    // Max-heap of the best _k candidates so far
+    std::priority_queue<Entry> best;
+    auto worst_dist = [&] {
+        return (int)best.size() < _k ? tg::inf<float> : best.top().dist;
+    };
+
+    std::vector<int> stack = { 0 };
+    while (!stack.empty()) {
+        const auto& node = nodes[stack.back()];
+        stack.pop_back();
+
+        if (node.children < 0) {
+            for (int i = node.begin; i < node.end; ++i) {
+                const Entry e = { tg::distance_sqr(_p, items[i].p), items[i].id };
+                if ((int)best.size() < _k) {
+                    best.push(e);
+                }
+                else if (e < best.top()) {
+                    best.pop();
+                    best.push(e);
+                }
+            }
+            continue;
+        }
+
+        const float diff = _p[node.axis] - node.split;
+        const int near = diff <= 0.0f ? node.children : node.children + 1;
+        const int far = diff <= 0.0f ? node.children + 1 : node.children;
+        if (diff * diff <= worst_dist()) {
+            stack.push_back(far);
+        }
+        stack.push_back(near); // Visited first
+    }
+
+    result.resize(best.size());
+    for (int i = (int)best.size() - 1; i >= 0; --i) {
+        result[i] = best.top().id;
+        best.pop();
+    }
+    return result;
+}
+
+int KDTree::size() const
+{
+    return items.size();
+}
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <polymesh/pm.hh>
+#include <typed-geometry/tg.hh>
+
+#include <vector>
+
+namespace LayoutEmbedding {
+
+/// Static KD-tree over a set of points for nearest neighbor queries,
+/// e.g. over the vertex positions of a target mesh to match layout vertices or to snap arbitrary points to the surface.
+///
+/// Points are identified by integer ids (vertex indices when built from a vertex attribute).
+/// Distances are compared exactly like a brute-force scan using tg::distance_sqr would,
+/// and ties are broken towards smaller ids, so queries return the same result as such a scan in id order.
+class KDTree
+{
+public:
+    KDTree() = default;
+
+    /// Ids are the positions in _points.
+    explicit KDTree(const std::vector<tg::pos3>& _points);
+
+    /// Over all vertices of the mesh. Ids are vertex indices.
+    explicit KDTree(const pm::vertex_attribute<tg::pos3>& _pos);
+
+    void build(const std::vector<tg::pos3>& _points, const std::vector<int>& _ids);
+
+    /// Id of the point closest to _p. -1 if the tree is empty.
+    int nearest(const tg::pos3& _p) const;
+
+    /// Id of the point closest to _p among those for which _accept(id) is true. -1 if there is none.
+    /// Subtrees are still pruned by distance, so this is fast as long as few points close to _p are rejected.
+    template <typename Pred>
+    int nearest_if(const tg::pos3& _p, Pred&& _accept) const;
+
+    /// Ids of the (up to) _k points closest to _p, ordered by increasing distance.
+    std::vector<int> k_nearest(const tg::pos3& _p, const int _k) const;
+
+    int size() const;
+
+private:
+    struct Node
+    {
+        int begin = 0; // Range in items
+        int end = 0;
+        int children = -1; // Index of the left child, the right one follows. -1 for leaves.
+        int axis = 0;
+        float split = 0.0f;
+    };
+
+    struct Item
+    {
+        tg::pos3 p;
+        int id;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Item> items;
+
+    void build_node(const int _node, const int _begin, const int _end);
+
+    /// Lexicographic (distance, id) comparison
+    static bool closer(const float _dist_a, const int _id_a, const float _dist_b, const int _id_b)
+    {
+        return _dist_a < _dist_b || (_dist_a == _dist_b && _id_a < _id_b);
+    }
+
+    template <typename Pred>
+    void nearest_if_rec(const int _node, const tg::pos3& _p, Pred& _accept, float& _best_dist, int& _best_id) const;
+};
+
+template <typename Pred>
+int KDTree::nearest_if(const tg::pos3& _p, Pred&& _accept) const
+{
+    if (nodes.empty()) {
+        return -1;
+    }
+    float best_dist = tg::inf<float>;
+    int best_id = -1;
+    nearest_if_rec(0, _p, _accept, best_dist, best_id);
+    return best_id;
+}
+
+template <typename Pred>
+void KDTree::nearest_if_rec(const int _node, const tg::pos3& _p, Pred& _accept, float& _best_dist, int& _best_id) const
+{
+    const auto& node = nodes[_node];
+    if (node.children < 0) {
+        for (int i = node.begin; i < node.end; ++i) {
+            const auto& item = items[i];
+            const float dist = tg::distance_sqr(_p, item.p);
+            if (closer(dist, item.id, _best_dist, _best_id) && _accept(item.id)) {
+                _best_dist = dist;
+                _best_id = item.id;
+            }
+        }
+        return;
+    }
+
+    // Near side first. The far side can only contain a better point if the splitting plane is not farther away
+    // (equal distances matter for the tie breaking).
+    const float diff = _p[node.axis] - node.split;
+    const int near = diff <= 0.0f ? node.children : node.children + 1;
+    const int far = diff <= 0.0f ? node.children + 1 : node.children;
+    nearest_if_rec(near, _p, _accept, _best_dist, _best_id);
+    if (diff * diff <= _best_dist) {
+        nearest_if_rec(far, _p, _accept, _best_dist, _best_id);
+    }
+}
+
+}
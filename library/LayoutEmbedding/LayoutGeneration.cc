@@ -1,11 +1,10 @@
 #include "LayoutGeneration.hh"
 
+#include <LayoutEmbedding/KDTree.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
 
 #include <polymesh/algorithms/decimate.hh>
 
-#include <set>
-
 namespace LayoutEmbedding {
 
 void make_layout_by_decimation(EmbeddingInput& _input, int _n_vertices)
@@ -30,25 +29,15 @@ void make_layout_by_decimation(EmbeddingInput& _input, int _n_vertices)
 
 void find_matching_vertices_by_proximity(EmbeddingInput& _input)
 {
-    std::set<pm::vertex_index> t_matched_v_ids;
+    const KDTree tree(_input.t_pos);
+    std::vector<char> t_matched(_input.t_m.all_vertices().size(), false);
 
     for (const auto& l_v : _input.l_m.vertices()) {
-        auto best_distance_sqr = tg::inf<double>;
-        auto best_t_v = pm::vertex_handle::invalid;
-        for (const auto& t_v : _input.t_m.vertices()) {
-            // Don't match the same target vertex twice
-            if (t_matched_v_ids.count(t_v.idx)) {
-                continue;
-            }
-            const auto distance_sqr = tg::distance_sqr(_input.l_pos[l_v], _input.t_pos[t_v]);
-            if (distance_sqr < best_distance_sqr) {
-                best_t_v = t_v;
-                best_distance_sqr = distance_sqr;
-            }
-        }
-        LE_ASSERT(best_t_v.is_valid());
-        _input.l_matching_vertex[l_v] = best_t_v;
-        t_matched_v_ids.insert(best_t_v.idx);
+        // Don't match the same target vertex twice
+        const int id = tree.nearest_if(_input.l_pos[l_v], [&] (int _id) { return !t_matched[_id]; });
+        LE_ASSERT_GEQ(id, 0);
+        _input.l_matching_vertex[l_v] = _input.t_m[pm::vertex_index(id)];
+        t_matched[id] = true;
     }
 }
 
@@ -0,0 +1,326 @@
+#include "MeshIO.hh"
+
+#include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/MappedFile.hh>
+#include <LayoutEmbedding/Util/Parsing.hh>
+#include <LayoutEmbedding/Util/Timer.hh>
+
+#include <polymesh/formats.hh>
+
+#include <algorithm>
+#include <cctype>
+
+namespace LayoutEmbedding {
+
+namespace
+{
+
+/// Positions and faces as parsed from (part of) a file
+struct ParsedMesh
+{
+    std::vector<float> pos; // 3 per vertex
+    std::vector<int> face_offsets = { 0 };
+    std::vector<int> face_vertices;
+
+    // OBJ only: Slots in face_vertices holding indices relative to the first vertex of the chunk (negative OBJ indices)
+    std::vector<int> chunk_relative;
+
+    bool ok = true;
+};
+
+/// Splits [_begin, _end) into ranges of about _chunk_size bytes at line boundaries.
+std::vector<std::pair<const char*, const char*>> split_lines(const char* _begin, const char* _end, const size_t _chunk_size)
+{
+    std::vector<std::pair<const char*, const char*>> chunks;
+    const char* p = _begin;
+    while (p < _end) {
+        const char* q = (size_t)(_end - p) > _chunk_size ? next_line(p + _chunk_size, _end) : _end;
+        chunks.push_back({p, q});
+        p = q;
+    }
+    return chunks;
+}
+
+void parse_obj_chunk(const char* _p, const char* _end, ParsedMesh& _chunk)
+{
+    while (_p < _end) {
+        const char* line_end = next_line(_p, _end);
+        const char* p = skip_blanks(_p, line_end);
+        if (line_end - p >= 2 && is_blank(p[1])) {
+            if (p[0] == 'v') {
+                ++p;
+                float x, y, z;
+                if (!parse_float(p, line_end, x) || !parse_float(p, line_end, y) || !parse_float(p, line_end, z)) {
+                    _chunk.ok = false;
+                    return;
+                }
+                _chunk.pos.push_back(x);
+                _chunk.pos.push_back(y);
+                _chunk.pos.push_back(z);
+            }
+            else if (p[0] == 'f') {
+                ++p;
+                const int num_vertices = _chunk.pos.size() / 3;
+                while (!at_line_end(p, line_end)) {
+                    int idx;
+                    if (!parse_int(p, line_end, idx) || idx == 0) {
+                        _chunk.ok = false;
+                        return;
+                    }
+                    if (idx > 0) {
+                        _chunk.face_vertices.push_back(idx - 1);
+                    }
+                    else {
+                        _chunk.chunk_relative.push_back(_chunk.face_vertices.size());
+                        _chunk.face_vertices.push_back(num_vertices + idx);
+                    }
+                    // Skip texture coordinate and normal indices
+                    while (p < line_end && !is_blank(*p) && *p != '\n') {
+                        ++p;
+                    }
+                }
+                _chunk.face_offsets.push_back(_chunk.face_vertices.size());
+            }
+        }
+        _p = line_end;
+    }
+}
+
+bool parse_obj(const char* _begin, const char* _end, const MeshLoadSettings& _settings, ParsedMesh& _mesh)
+{
+    const auto ranges = split_lines(_begin, _end, _settings.chunk_size);
+    std::vector<ParsedMesh> chunks(ranges.size());
+
+    #pragma omp parallel for schedule(dynamic) if(_settings.parallel)
+    for (int i = 0; i < (int)ranges.size(); ++i) {
+        parse_obj_chunk(ranges[i].first, ranges[i].second, chunks[i]);
+    }
+
+    // Concatenate in file order
+    size_t num_pos = 0;
+    size_t num_face_vertices = 0;
+    size_t num_faces = 0;
+    for (const auto& chunk : chunks) {
+        if (!chunk.ok) {
+            return false;
+        }
+        num_pos += chunk.pos.size();
+        num_face_vertices += chunk.face_vertices.size();
+        num_faces += chunk.face_offsets.size() - 1;
+    }
+    _mesh.pos.reserve(num_pos);
+    _mesh.face_vertices.reserve(num_face_vertices);
+    _mesh.face_offsets.reserve(num_faces + 1);
+
+    for (auto& chunk : chunks) {
+        const int vertex_offset = _mesh.pos.size() / 3;
+        for (const int slot : chunk.chunk_relative) {
+            chunk.face_vertices[slot] += vertex_offset;
+        }
+        const int face_vertex_offset = _mesh.face_vertices.size();
+        _mesh.pos.insert(_mesh.pos.end(), chunk.pos.begin(), chunk.pos.end());
+        _mesh.face_vertices.insert(_mesh.face_vertices.end(), chunk.face_vertices.begin(), chunk.face_vertices.end());
+        for (int i = 1; i < (int)chunk.face_offsets.size(); ++i) {
+            _mesh.face_offsets.push_back(face_vertex_offset + chunk.face_offsets[i]);
+        }
+    }
+    return true;
+}
+
+bool parse_off(const char* _begin, const char* _end, const MeshLoadSettings& _settings, ParsedMesh& _mesh)
+{
+    // Header: "OFF", then the element counts (possibly on the same line)
+    const char* p = _begin;
+    auto skip_empty_lines = [&] {
+        while (p < _end && at_line_end(p, _end)) {
+            p = next_line(p, _end);
+        }
+        p = skip_blanks(p, _end);
+    };
+    skip_empty_lines();
+    if (_end - p < 3 || std::strncmp(p, "OFF", 3) != 0) {
+        return false;
+    }
+    p += 3;
+    if (at_line_end(p, _end)) {
+        p = next_line(p, _end);
+        skip_empty_lines();
+    }
+    int num_vertices, num_faces, num_edges;
+    if (!parse_int(p, _end, num_vertices) || !parse_int(p, _end, num_faces) || !parse_int(p, _end, num_edges)) {
+        return false;
+    }
+    if (num_vertices < 0 || num_faces < 0) {
+        return false;
+    }
+    p = next_line(p, _end);
+
+    // Body: One record (vertex or face) per non-empty line.
+    // First count the records per chunk to know which records each chunk holds, then parse.
+    const auto ranges = split_lines(p, _end, _settings.chunk_size);
+    std::vector<int> first_record(ranges.size() + 1, 0);
+
+    #pragma omp parallel for schedule(dynamic) if(_settings.parallel)
+    for (int i = 0; i < (int)ranges.size(); ++i) {
+        int count = 0;
+        for (const char* q = ranges[i].first; q < ranges[i].second; q = next_line(q, ranges[i].second)) {
+            if (!at_line_end(q, ranges[i].second)) {
+                ++count;
+            }
+        }
+        first_record[i + 1] = count;
+    }
+    for (int i = 0; i < (int)ranges.size(); ++i) {
+        first_record[i + 1] += first_record[i];
+    }
+    if (first_record.back() < num_vertices + num_faces) {
+        return false;
+    }
+
+    _mesh.pos.resize(3 * (size_t)num_vertices);
+    std::vector<ParsedMesh> chunks(ranges.size());
+
+    #pragma omp parallel for schedule(dynamic) if(_settings.parallel)
+    for (int i = 0; i < (int)ranges.size(); ++i) {
+        auto& chunk = chunks[i];
+        int record = first_record[i];
+        for (const char* q = ranges[i].first; q < ranges[i].second && record < num_vertices + num_faces; ) {
+            const char* line_end = next_line(q, ranges[i].second);
+            if (at_line_end(q, line_end)) {
+                q = line_end;
+                continue;
+            }
+            if (record < num_vertices) {
+                float* pos = &_mesh.pos[3 * (size_t)record];
+                if (!parse_float(q, line_end, pos[0]) || !parse_float(q, line_end, pos[1]) || !parse_float(q, line_end, pos[2])) {
+                    chunk.ok = false;
+                    break;
+                }
+            }
+            else {
+                int n;
+                if (!parse_int(q, line_end, n) || n < 3) {
+                    chunk.ok = false;
+                    break;
+                }
+                for (int j = 0; j < n; ++j) {
+                    int idx;
+                    if (!parse_int(q, line_end, idx)) {
+                        chunk.ok = false;
+                        break;
+                    }
+                    chunk.face_vertices.push_back(idx);
+                }
+                if (!chunk.ok) {
+                    break;
+                }
+                chunk.face_offsets.push_back(chunk.face_vertices.size());
+            }
+            ++record;
+            q = line_end;
+        }
+    }
+
+    for (const auto& chunk : chunks) {
+        if (!chunk.ok) {
+            return false;
+        }
+        const int face_vertex_offset = _mesh.face_vertices.size();
+        _mesh.face_vertices.insert(_mesh.face_vertices.end(), chunk.face_vertices.begin(), chunk.face_vertices.end());
+        for (int i = 1; i < (int)chunk.face_offsets.size(); ++i) {
+            _mesh.face_offsets.push_back(face_vertex_offset + chunk.face_offsets[i]);
+        }
+    }
+    return (int)_mesh.face_offsets.size() - 1 == num_faces;
+}
+
+bool build_mesh(const ParsedMesh& _mesh, pm::Mesh& _m, pm::vertex_attribute<tg::pos3>& _pos)
+{
+    const int num_vertices = _mesh.pos.size() / 3;
+    const int num_faces = _mesh.face_offsets.size() - 1;
+    for (const int idx : _mesh.face_vertices) {
+        if (idx < 0 || idx >= num_vertices) {
+            return false;
+        }
+    }
+
+    _m.clear();
+    _m.vertices().reserve(num_vertices);
+    _m.faces().reserve(num_faces);
+    _m.halfedges().reserve(_mesh.face_vertices.size() + num_vertices); // Interior plus some boundary halfedges
+    _m.edges().reserve((_mesh.face_vertices.size() + num_vertices) / 2);
+
+    for (int i = 0; i < num_vertices; ++i) {
+        const auto v = _m.vertices().add();
+        _pos[v] = tg::pos3(_mesh.pos[3 * i], _mesh.pos[3 * i + 1], _mesh.pos[3 * i + 2]);
+    }
+
+    const auto vertices = _m.vertices();
+    std::vector<pm::vertex_handle> f_vertices;
+    for (int i = 0; i < num_faces; ++i) {
+        const int begin = _mesh.face_offsets[i];
+        const int end = _mesh.face_offsets[i + 1];
+        if (end - begin == 3) {
+            const int* fv = &_mesh.face_vertices[begin];
+            _m.faces().add(vertices[fv[0]], vertices[fv[1]], vertices[fv[2]]);
+        }
+        else {
+            f_vertices.clear();
+            for (int j = begin; j < end; ++j) {
+                f_vertices.push_back(vertices[_mesh.face_vertices[j]]);
+            }
+            _m.faces().add(f_vertices);
+        }
+    }
+    return true;
+}
+
+}
+
+bool load_mesh(const std::filesystem::path& _path, pm::Mesh& _m, pm::vertex_attribute<tg::pos3>& _pos, const MeshLoadSettings& _settings, MeshLoadTimings* _timings)
+{
+    MeshLoadTimings timings;
+
+    std::string ext = _path.extension().string();
+    std::transform(ext.begin(), ext.end(), ext.begin(), [] (unsigned char c) { return std::tolower(c); });
+
+    bool loaded = false;
+    if (ext == ".obj" || ext == ".off") {
+        Timer timer;
+        const MappedFile file(_path);
+        timings.map = timer.elapsed_seconds();
+        if (!file.is_open()) {
+            return false;
+        }
+
+        timer.restart();
+        ParsedMesh mesh;
+        const char* begin = file.data();
+        const char* end = file.data() + file.size();
+        const bool parsed = (ext == ".obj") ? parse_obj(begin, end, _settings, mesh) : parse_off(begin, end, _settings, mesh);
+        timings.parse = timer.elapsed_seconds();
+
+        if (parsed) {
+            timer.restart();
+            loaded = build_mesh(mesh, _m, _pos);
+            timings.build = timer.elapsed_seconds();
+        }
+        if (!loaded) {
+            std::cout << "Fast loader could not parse " << _path << ". Falling back to pm::load." << std::endl;
+        }
+    }
+
+    if (!loaded) {
+        Timer timer;
+        timings.fallback = true;
+        loaded = pm::load(_path.string(), _m, _pos);
+        timings.build += timer.elapsed_seconds();
+    }
+
+    if (_timings) {
+        *_timings = timings;
+    }
+    return loaded;
+}
+
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <polymesh/pm.hh>
+#include <typed-geometry/tg.hh>
+
+#include <filesystem>
+
+namespace LayoutEmbedding {
+
+struct MeshLoadSettings
+{
+    bool parallel = true;      // Parse chunks of the file concurrently
+    size_t chunk_size = 1 << 20; // Bytes per chunk
+};
+
+struct MeshLoadTimings
+{
+    double map = 0.0;   // Opening / mapping the file
+    double parse = 0.0; // Parsing positions and face indices
+    double build = 0.0; // Building the polymesh connectivity
+    bool fallback = false; // Loaded via pm::load
+
+    double total() const { return map + parse + build; }
+};
+
+/// Loads a polygon mesh. Same result as pm::load (vertex and face order are preserved),
+/// but .obj and .off files are parsed from a memory-mapped file, optionally in parallel, and the mesh is built in bulk.
+/// Other formats, and files the fast parser does not understand, are passed on to pm::load.
+bool load_mesh(
+        const std::filesystem::path& _path,
+        pm::Mesh& _m,
+        pm::vertex_attribute<tg::pos3>& _pos,
+        const MeshLoadSettings& _settings = MeshLoadSettings(),
+        MeshLoadTimings* _timings = nullptr);
+
+}
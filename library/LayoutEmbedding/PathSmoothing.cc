@@ -3,9 +3,13 @@
 #include <LayoutEmbedding/Snake.hh>
 #include <LayoutEmbedding/Harmonic.hh>
 #include <LayoutEmbedding/Util/Assert.hh>
+#include <LayoutEmbedding/Util/Profiling.hh>
+#include <LayoutEmbedding/Util/Timer.hh>
 
-#include <glow-extras/timing/CpuTimer.hh>
+#include <algorithm>
+#include <memory>
 #include <queue>
+#include <unordered_map>
 
 namespace LayoutEmbedding
 {
@@ -88,6 +92,7 @@ Embedding subdivide(
         }
 
         em.target_mesh().compactify();
+        em.invalidate_caches();
     }
 
     return em;
@@ -116,7 +121,10 @@ void preprocess_split_edges(
     }
 
     if (n_splits > 0)
+    {
+        _em.invalidate_caches();
         std::cout << "Split " << n_splits << " edges during path smoothing preprocess." << std::endl;
+    }
 }
 
 void extract_flap_region(
@@ -300,51 +308,237 @@ Snake transfer_snake_to_target(
     return res;
 }
 
-/**
- * Parametrize flap and straighten edge.
- */
-bool smooth_path(
-        Embedding& _em,
-        const pm::halfedge_handle& _l_h,
-        const bool _quad_flap_to_rectangle)
+/// Parametrization of the most recent flap of a layout edge, by target vertex index.
+/// Used to warm-start the iterative solver in subsequent iterations.
+/// Only recorded for flaps large enough to skip the direct solver, empty otherwise.
+using FlapParamCache = std::unordered_map<int, tg::dpos2>;
+
+/// Smoothing a single layout edge, split into phases:
+/// prepare_flap reads the Embedding (and registers attributes on the target mesh), so it has to run serially.
+/// solve_flap only touches the private region mesh and can run concurrently for independent flaps.
+/// commit_flap modifies the Embedding and has to run serially again.
+struct FlapProblem
 {
-    // Extract flap region mesh
+    pm::halfedge_handle l_h;
+    FlapParamCache* param_cache = nullptr;
+
     pm::Mesh region;
     pm::vertex_attribute<tg::pos3> region_pos;
-    pm::vertex_attribute<pm::vertex_handle> v_target_to_region;
     pm::halfedge_attribute<pm::halfedge_handle> h_region_to_target;
-    extract_flap_region(_em, _l_h, region, region_pos, v_target_to_region, h_region_to_target);
-
-    // Construct 2D n-gon
     pm::vertex_attribute<bool> constrained;
     VertexParam constraint_pos;
-    constrain_flap_boundary(_em, _l_h, v_target_to_region, region, constrained, constraint_pos, _quad_flap_to_rectangle);
+    VertexParam initial_guess;
+    pm::vertex_handle r_v_from;
+    pm::vertex_handle r_v_to;
+
+    bool success = false;
+    Snake t_snake;
+};
+
+void prepare_flap(
+        const Embedding& _em,
+        const pm::halfedge_handle& _l_h,
+        const bool _quad_flap_to_rectangle,
+        FlapParamCache& _param_cache,
+        FlapProblem& _problem)
+{
+    _problem.l_h = _l_h;
+    _problem.param_cache = &_param_cache;
+
+    // Extract flap region mesh
+    pm::vertex_attribute<pm::vertex_handle> v_target_to_region;
+    extract_flap_region(_em, _l_h, _problem.region, _problem.region_pos, v_target_to_region, _problem.h_region_to_target);
+
+    // Construct 2D n-gon
+    constrain_flap_boundary(_em, _l_h, v_target_to_region, _problem.region, _problem.constrained, _problem.constraint_pos, _quad_flap_to_rectangle);
+
+    // Initial guess from the previous iteration (target vertices are never removed, so their indices stay valid)
+    _problem.initial_guess = _problem.region.vertices().make_attribute<tg::dpos2>(tg::dpos2(0.0, 0.0));
+    if (!_param_cache.empty())
+    {
+        for (auto r_v : _problem.region.vertices())
+        {
+            const auto t_v = _problem.h_region_to_target[r_v.any_outgoing_halfedge()].vertex_from();
+            if (auto it = _param_cache.find(t_v.idx.value); it != _param_cache.end())
+                _problem.initial_guess[r_v] = it->second;
+        }
+    }
+
+    _problem.r_v_from = v_target_to_region[_em.matching_target_vertex(_l_h.vertex_from())];
+    _problem.r_v_to = v_target_to_region[_em.matching_target_vertex(_l_h.vertex_to())];
+}
+
+/**
+ * Parametrize flap and trace straight line.
+ */
+void solve_flap(
+        FlapProblem& _problem)
+{
+    _problem.success = false;
 
     // Compute harmonic parametrization
     // Try a few times with successively more uniform weights
+    // The factorizations are freed right after solving: The flap usually changes before it is solved again,
+    // so keeping them alive (for every flap) would cost a lot of memory for little reuse.
+    HarmonicSolver solver;
     VertexParam region_param;
-    if (!harmonic_parametrization(region_pos, constrained, constraint_pos, region_param, LaplaceWeights::MeanValue, false) || !injective(region_param))
+    if (!harmonic_parametrization(_problem.region_pos, _problem.constrained, _problem.constraint_pos, region_param, LaplaceWeights::MeanValue, false, nullptr, &solver) || !injective(region_param))
     {
-        if (!harmonic_parametrization(region_pos, constrained, constraint_pos, region_param, LaplaceWeights::Uniform, true) || !injective(region_param))
+        if (!harmonic_parametrization(_problem.region_pos, _problem.constrained, _problem.constraint_pos, region_param, LaplaceWeights::Uniform, true, &_problem.initial_guess, &solver) || !injective(region_param))
         {
             std::cout << "Path smoothing failed" << std::endl;
-            return false;
+            return;
+        }
+    }
+
+    // Remember the result only if the next solve of this flap will likely be iterative.
+    // (The rare failures of the direct solver then start from zero, as in the first iteration.)
+    auto& param_cache = *_problem.param_cache;
+    param_cache.clear();
+    if (solver.num_free_vertices() > harmonic_max_direct_solve_size)
+    {
+        param_cache.reserve(_problem.region.vertices().size());
+        for (auto r_v : _problem.region.vertices())
+        {
+            const auto t_v = _problem.h_region_to_target[r_v.any_outgoing_halfedge()].vertex_from();
+            param_cache[t_v.idx.value] = region_param[r_v];
         }
     }
 
     // Compute snake by tracing straight line in parametrization
-    const auto r_v_from = v_target_to_region[_em.matching_target_vertex(_l_h.vertex_from())];
-    const auto r_v_to = v_target_to_region[_em.matching_target_vertex(_l_h.vertex_to())];
-    const auto r_snake = snake_from_parametrization(region_param, r_v_from, r_v_to);
-    const auto t_snake = transfer_snake_to_target(r_snake, h_region_to_target);
+    const auto r_snake = snake_from_parametrization(region_param, _problem.r_v_from, _problem.r_v_to);
+    _problem.t_snake = transfer_snake_to_target(r_snake, _problem.h_region_to_target);
+    _problem.success = true;
+}
 
-    // Embed snake in target mesh
-    _em.unembed_path(_l_h);
-    _em.embed_path(_l_h, t_snake);
+/**
+ * Embed straightened edge.
+ */
+bool commit_flap(
+        Embedding& _em,
+        const FlapProblem& _problem)
+{
+    if (!_problem.success)
+        return false;
+
+    _em.unembed_path(_problem.l_h);
+    _em.embed_path(_problem.l_h, _problem.t_snake);
 
     return true;
 }
 
+std::vector<tg::pos3> embedded_path_positions(
+        const Embedding& _em,
+        const pm::halfedge_handle& _l_h)
+{
+    std::vector<tg::pos3> result;
+    for (auto t_v : _em.get_embedded_path(_l_h))
+        result.push_back(_em.target_pos()[t_v]);
+    return result;
+}
+
+/// Point at arc length parameter _t in [0, 1] along a polyline
+tg::pos3 polyline_point(
+        const std::vector<tg::pos3>& _polyline,
+        const std::vector<double>& _arc_length,
+        const double _t)
+{
+    const double s = _t * _arc_length.back();
+    const int i = std::upper_bound(_arc_length.begin(), _arc_length.end(), s) - _arc_length.begin();
+    if (i <= 0)
+        return _polyline.front();
+    if (i >= (int)_polyline.size())
+        return _polyline.back();
+
+    const double segment_length = _arc_length[i] - _arc_length[i - 1];
+    const double lambda = segment_length > 0.0 ? (s - _arc_length[i - 1]) / segment_length : 0.0;
+    return tg::mix(_polyline[i - 1], _polyline[i], lambda);
+}
+
+/// Maximum distance between corresponding points of two polylines, both sampled uniformly by arc length
+double path_displacement(
+        const std::vector<tg::pos3>& _before,
+        const std::vector<tg::pos3>& _after)
+{
+    auto arc_length = [] (const std::vector<tg::pos3>& _polyline)
+    {
+        std::vector<double> result = { 0.0 };
+        for (int i = 1; i < (int)_polyline.size(); ++i)
+            result.push_back(result.back() + tg::distance(_polyline[i - 1], _polyline[i]));
+        return result;
+    };
+    const auto arc_length_before = arc_length(_before);
+    const auto arc_length_after = arc_length(_after);
+
+    const int n_samples = 64;
+    double result = 0.0;
+    for (int i = 0; i <= n_samples; ++i)
+    {
+        const double t = (double)i / n_samples;
+        const auto p_before = polyline_point(_before, arc_length_before, t);
+        const auto p_after = polyline_point(_after, arc_length_after, t);
+        result = std::max(result, (double)tg::distance(p_before, p_after));
+    }
+    return result;
+}
+
+double target_diagonal(
+        const Embedding& _em)
+{
+    auto p_min = _em.target_pos()[_em.target_mesh().vertices().first()];
+    auto p_max = p_min;
+    for (auto t_v : _em.target_mesh().vertices())
+    {
+        const auto& p = _em.target_pos()[t_v];
+        for (int i = 0; i < 3; ++i)
+        {
+            p_min[i] = std::min(p_min[i], p[i]);
+            p_max[i] = std::max(p_max[i], p[i]);
+        }
+    }
+    return tg::distance(p_min, p_max);
+}
+
+/**
+ * Greedily colors the given layout edges such that edges of the same color have disjoint flaps,
+ * i.e. do not share an incident layout face. Returns the edges grouped by color,
+ * each group in the order of _l_edges.
+ */
+std::vector<std::vector<pm::edge_handle>> color_independent_flaps(
+        const pm::Mesh& _l_m,
+        const std::vector<pm::edge_handle>& _l_edges)
+{
+    auto color = _l_m.edges().make_attribute<int>(-1);
+    std::vector<std::vector<pm::edge_handle>> classes;
+    for (auto l_e : _l_edges)
+    {
+        if (color[l_e] >= 0)
+            continue; // Duplicate
+
+        // Colors of all edges whose flaps overlap with the flap of l_e
+        std::vector<bool> used(classes.size(), false);
+        for (auto l_f : { l_e.faceA(), l_e.faceB() })
+        {
+            for (auto l_e_f : l_f.edges())
+            {
+                if (color[l_e_f] >= 0)
+                    used[color[l_e_f]] = true;
+            }
+        }
+
+        int c = 0;
+        while (c < (int)used.size() && used[c])
+            ++c;
+        if (c == (int)classes.size())
+            classes.emplace_back();
+
+        color[l_e] = c;
+        classes[c].push_back(l_e);
+    }
+
+    return classes;
+}
+
 }
 
 Embedding smooth_paths(
@@ -361,27 +555,117 @@ Embedding smooth_paths(
         const int _n_iters,
         const bool _quad_flap_to_rectangle)
 {
-    glow::timing::CpuTimer timer;
+    PathSmoothingSettings settings;
+    settings.max_iters = _n_iters;
+    settings.quad_flap_to_rectangle = _quad_flap_to_rectangle;
+    return smooth_paths(_em_orig, _l_edges, settings);
+}
+
+Embedding smooth_paths(
+        const Embedding& _em_orig,
+        const std::vector<pm::edge_handle>& _l_edges,
+        const PathSmoothingSettings& _settings,
+        PathSmoothingStats* _stats)
+{
+    LE_PROFILE_SCOPE("smooth_paths");
+    Timer timer;
 
     Embedding em = _em_orig; // copy
 
     // Split non-boundary edges with both end vertices on the same path
     preprocess_split_edges(em);
 
-    for (int iter = 0; iter < _n_iters; ++iter)
+    std::vector<pm::edge_handle> l_edges;
+    for (auto l_e : _l_edges)
+    {
+        if (!l_e.is_boundary())
+            l_edges.push_back(l_e);
+    }
+
+    // Edges within a color class have disjoint flaps and can be smoothed independently
+    const auto color_classes = color_independent_flaps(em.layout_mesh(), l_edges);
+
+    const int l_num_e = em.layout_mesh().all_edges().size();
+    PathSmoothingStats stats;
+    stats.times_smoothed.resize(l_num_e, 0);
+    stats.last_displacement.resize(l_num_e, 0.0);
+    stats.max_displacement.resize(l_num_e, 0.0);
+
+    // Accumulated displacement of the paths bounding each flap since its edge was last smoothed
+    std::vector<double> flap_displacement(l_num_e, std::numeric_limits<double>::infinity());
+    const double tolerance = _settings.displacement_tolerance * target_diagonal(em);
+
+    std::vector<FlapParamCache> param_caches(l_num_e);
+    for (int iter = 0; iter < _settings.max_iters; ++iter)
     {
-        for (auto l_e : _l_edges)
+        int n_smoothed_iter = 0;
+        double max_displacement_iter = 0.0;
+        for (const auto& color_class : color_classes)
         {
-            if (!l_e.is_boundary())
-                smooth_path(em, l_e.halfedgeA(), _quad_flap_to_rectangle);
+            std::vector<std::unique_ptr<FlapProblem>> problems;
+            for (auto l_e : color_class)
+            {
+                if (_settings.use_work_list && !(flap_displacement[l_e.idx.value] > tolerance))
+                    continue;
+
+                problems.push_back(std::make_unique<FlapProblem>());
+                prepare_flap(em, l_e.halfedgeA(), _settings.quad_flap_to_rectangle, param_caches[l_e.idx.value], *problems.back());
+            }
+
+            #pragma omp parallel for schedule(dynamic)
+            for (int i = 0; i < (int)problems.size(); ++i)
+                solve_flap(*problems[i]);
+
+            // Deterministic order
+            for (const auto& problem : problems)
+            {
+                const auto l_e = problem->l_h.edge();
+                const auto path_before = embedded_path_positions(em, problem->l_h);
+                if (!commit_flap(em, *problem))
+                    continue;
+
+                const double displacement = path_displacement(path_before, embedded_path_positions(em, problem->l_h));
+                stats.times_smoothed[l_e.idx.value] += 1;
+                stats.last_displacement[l_e.idx.value] = displacement;
+                stats.max_displacement[l_e.idx.value] = std::max(stats.max_displacement[l_e.idx.value], displacement);
+                ++n_smoothed_iter;
+                max_displacement_iter = std::max(max_displacement_iter, displacement);
+
+                // The edge's own flap is unaffected by its smoothing. All flaps bounded by it are.
+                flap_displacement[l_e.idx.value] = 0.0;
+                for (auto l_f : { l_e.faceA(), l_e.faceB() })
+                {
+                    for (auto l_e_f : l_f.edges())
+                    {
+                        if (l_e_f != l_e)
+                            flap_displacement[l_e_f.idx.value] += displacement;
+                    }
+                }
+            }
         }
+
+        stats.paths_smoothed += n_smoothed_iter;
+        stats.iterations = iter + 1;
+
+        if (_settings.use_work_list)
+        {
+            std::cout << "Path smoothing iteration " << iter << ": "
+                      << n_smoothed_iter << " paths smoothed, "
+                      << "max displacement " << max_displacement_iter << "." << std::endl;
+        }
+
+        if (n_smoothed_iter == 0)
+            break;
     }
 
-    std::cout << "Smoothing paths (" << _n_iters << " iterations ) took "
-              << timer.elapsedSecondsD() << " s. "
+    std::cout << "Smoothing paths (" << stats.iterations << " iterations ) took "
+              << timer.elapsed_seconds() << " s. "
               << "Resulting mesh has " << em.target_mesh().vertices().size() << " vertices."
               << std::endl;
 
+    if (_stats)
+        *_stats = std::move(stats);
+
     return em;
 }
 
@@ -5,6 +5,29 @@
 namespace LayoutEmbedding
 {
 
+struct PathSmoothingSettings
+{
+    int max_iters = 1;
+    bool quad_flap_to_rectangle = true;
+
+    // Work-list mode: In each iteration, only smooth edges whose flap changed, i.e. where the paths
+    // bounding the flap moved by more than displacement_tolerance (in total) since the edge was last smoothed.
+    // Stops early once no edge needs smoothing.
+    bool use_work_list = false;
+    double displacement_tolerance = 1e-4; // Relative to the bounding box diagonal of the target mesh
+};
+
+struct PathSmoothingStats
+{
+    int iterations = 0;
+    int paths_smoothed = 0;
+
+    // Per layout edge (by index)
+    std::vector<int> times_smoothed;
+    std::vector<double> last_displacement; // Max distance between the path before and after its last smoothing
+    std::vector<double> max_displacement;
+};
+
 /**
  * Perform loop subdivision on target mesh
  */
@@ -32,4 +55,13 @@ Embedding smooth_paths(
         const int _n_iters = 1,
         const bool _quad_flap_to_rectangle = true);
 
+/**
+ * Smooth selected edges, optionally in work-list mode (see PathSmoothingSettings)
+ */
+Embedding smooth_paths(
+        const Embedding& _em_orig,
+        const std::vector<pm::edge_handle>& _l_edges,
+        const PathSmoothingSettings& _settings,
+        PathSmoothingStats* _stats = nullptr);
+
 }
@@ -4,7 +4,10 @@
 #include <LayoutEmbedding/Embedding.hh>
 #include <LayoutEmbedding/ExactPredicates.h>
 #include <LayoutEmbedding/Util/Assert.hh>
-#include <LayoutEmbedding/Visualization/Visualization.hh>
+
+#include <algorithm>
+#include <exception>
+#include <memory>
 
 namespace LayoutEmbedding
 {
@@ -117,6 +120,90 @@ pm::edge_attribute<int> choose_loop_subdivisions(
     return subdivisions;
 }
 
+namespace
+{
+
+/// Parametrization of a single patch, split into three phases (like the flaps in PathSmoothing):
+/// prepare_patch reads the Embedding (and creates attributes on the target mesh) and has to run serially.
+/// solve_patch only touches the patch mesh and can run concurrently for all patches.
+/// The results are then written to the target mesh serially, in layout face order.
+struct PatchParametrization
+{
+    pm::face_handle l_f;
+
+    pm::Mesh p_m;
+    pm::vertex_attribute<tg::pos3> p_pos;
+    pm::halfedge_attribute<pm::halfedge_handle> h_patch_to_target;
+    pm::vertex_attribute<bool> p_constrained;
+    pm::vertex_attribute<tg::dpos2> p_constraint_value;
+
+    bool success = false;
+    VertexParam p_param;
+    std::exception_ptr error;
+};
+
+void prepare_patch(
+        const Embedding& _em,
+        const pm::face_handle& _l_f,
+        const pm::edge_attribute<int>& _l_subdivisions,
+        PatchParametrization& _patch)
+{
+    LE_ASSERT_EQ(_l_f.vertices().size(), 4);
+    _patch.l_f = _l_f;
+
+    // Extract patch mesh
+    pm::vertex_attribute<pm::vertex_handle> v_target_to_patch;
+    extract_patch(_em, _l_f, _patch.p_m, _patch.p_pos, v_target_to_patch, _patch.h_patch_to_target);
+
+    // Constrain patch boundary to rectangle
+    _patch.p_constrained = _patch.p_m.vertices().make_attribute<bool>(false);
+    _patch.p_constraint_value = _patch.p_m.vertices().make_attribute<tg::dpos2>();
+
+    const double width = _l_subdivisions[_l_f.halfedges().first().edge()] + 1.0;
+    const double height = _l_subdivisions[_l_f.halfedges().last().edge()] + 1.0;
+    const std::vector<tg::dpos2> corners = { {0.0, 0.0}, {width, 0.0}, {width, height}, {0.0, height} };
+    int corner_idx = 0;
+    for (auto l_h : _l_f.halfedges())
+    {
+        const double length_total = _em.embedded_path_length(l_h);
+        double length_acc = 0.0;
+        const auto t_path_vertices = _em.get_embedded_path(l_h);
+        for (int i = 0; i < t_path_vertices.size() - 1; ++i)
+        {
+            const auto t_vi = t_path_vertices[i];
+            const auto t_vj = t_path_vertices[i+1];
+            const double lambda_i = length_acc / length_total;
+            length_acc += tg::length(_em.target_pos()[t_vi] - _em.target_pos()[t_vj]);
+
+            const auto p_vi = v_target_to_patch[t_vi];
+            _patch.p_constrained[p_vi] = true;
+            _patch.p_constraint_value[p_vi] = (1.0 - lambda_i) * corners[corner_idx] + lambda_i * corners[(corner_idx + 1) % 4];
+        }
+
+        ++corner_idx;
+    }
+}
+
+void solve_patch(
+        PatchParametrization& _patch)
+{
+    // Compute Tutte embedding
+    // Try a few times with successively more uniform weights
+    try
+    {
+        _patch.success =
+                harmonic_parametrization(_patch.p_pos, _patch.p_constrained, _patch.p_constraint_value, _patch.p_param, LaplaceWeights::MeanValue, false) ||
+                harmonic_parametrization(_patch.p_pos, _patch.p_constrained, _patch.p_constraint_value, _patch.p_param, LaplaceWeights::Uniform, true);
+    }
+    catch (...)
+    {
+        // Exceptions must not leave the parallel region
+        _patch.error = std::current_exception();
+    }
+}
+
+}
+
 HalfedgeParam parametrize_patches(
         const Embedding& _em,
         const pm::edge_attribute<int>& _l_subdivisions)
@@ -124,67 +211,35 @@ HalfedgeParam parametrize_patches(
     LE_ASSERT(_em.is_complete());
     auto param = _em.target_mesh().halfedges().make_attribute<tg::dpos2>();
 
+    std::vector<std::unique_ptr<PatchParametrization>> patches;
     for (auto l_f : _em.layout_mesh().faces())
     {
-        LE_ASSERT_EQ(l_f.vertices().size(), 4);
-
-        // Extract patch mesh
-        pm::Mesh p_m;
-        pm::vertex_attribute<tg::pos3> p_pos;
-        pm::vertex_attribute<pm::vertex_handle> v_target_to_patch;
-        pm::halfedge_attribute<pm::halfedge_handle> h_patch_to_target;
-        extract_patch(_em, l_f, p_m, p_pos, v_target_to_patch, h_patch_to_target);
-
-        // Constrain patch boundary to rectangle
-        auto p_constrained = p_m.vertices().make_attribute<bool>(false);
-        auto p_constraint_value = p_m.vertices().make_attribute<tg::dpos2>();
-
-        const double width = _l_subdivisions[l_f.halfedges().first().edge()] + 1.0;
-        const double height = _l_subdivisions[l_f.halfedges().last().edge()] + 1.0;
-        const std::vector<tg::dpos2> corners = { {0.0, 0.0}, {width, 0.0}, {width, height}, {0.0, height} };
-        int corner_idx = 0;
-        for (auto l_h : l_f.halfedges())
-        {
-            const double length_total = _em.embedded_path_length(l_h);
-            double length_acc = 0.0;
-            const auto t_path_vertices = _em.get_embedded_path(l_h);
-            for (int i = 0; i < t_path_vertices.size() - 1; ++i)
-            {
-                const auto t_vi = t_path_vertices[i];
-                const auto t_vj = t_path_vertices[i+1];
-                const double lambda_i = length_acc / length_total;
-                length_acc += tg::length(_em.target_pos()[t_vi] - _em.target_pos()[t_vj]);
-
-                const auto p_vi = v_target_to_patch[t_vi];
-                p_constrained[p_vi] = true;
-                p_constraint_value[p_vi] = (1.0 - lambda_i) * corners[corner_idx] + lambda_i * corners[(corner_idx + 1) % 4];
-            }
+        patches.push_back(std::make_unique<PatchParametrization>());
+        prepare_patch(_em, l_f, _l_subdivisions, *patches.back());
+    }
 
-            ++corner_idx;
-        }
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < (int)patches.size(); ++i)
+        solve_patch(*patches[i]);
 
-        // Compute Tutte embedding
-        // Try a few times with successively more uniform weights
-        VertexParam p_param;
-        if (!harmonic_parametrization(p_pos, p_constrained, p_constraint_value, p_param, LaplaceWeights::MeanValue, false))
-        {
-            if (!harmonic_parametrization(p_pos, p_constrained, p_constraint_value, p_param, LaplaceWeights::Uniform, true))
-            {
-                LE_ERROR_THROW("Harmonic parametrization failed.");
-            }
-        }
+    for (const auto& patch : patches)
+    {
+        if (patch->error)
+            std::rethrow_exception(patch->error);
+        if (!patch->success)
+            LE_ERROR_THROW("Harmonic parametrization failed.");
 
-        for (auto v : p_m.vertices())
+        for (auto v : patch->p_m.vertices())
         {
-            LE_ASSERT(std::isfinite(p_param[v].x));
-            LE_ASSERT(std::isfinite(p_param[v].y));
+            LE_ASSERT(std::isfinite(patch->p_param[v].x));
+            LE_ASSERT(std::isfinite(patch->p_param[v].y));
         }
 
         // Transfer parametrization to target mesh
-        for (auto p_h : p_m.halfedges())
+        for (auto p_h : patch->p_m.halfedges())
         {
             if (!p_h.is_boundary())
-                param[h_patch_to_target[p_h]] = p_param[p_h.vertex_to()];
+                param[patch->h_patch_to_target[p_h]] = patch->p_param[p_h.vertex_to()];
         }
     }
 
@@ -272,43 +327,220 @@ std::pair<double, double> compute_bary(
     return std::make_pair(alpha, beta);
 }
 
-tg::pos3 point_on_surface(
-        const tg::dpos2& _p,
-        const std::vector<pm::face_handle> _t_patch,
-        const pm::vertex_attribute<tg::pos3> _pos,
-        const HalfedgeParam& _param)
+/// Locates points in the parameter domain of a single patch.
+/// The triangles of the patch are binned into a uniform grid over their bounding box in the parameter domain.
+class PatchLocator
 {
-    // To fix numerical issues at the patch boundary,
-    // try the lookup a few times while slowly growing each individual triangle.
-    const int n_attempts = 3;
-    double scale = 1.0;
-    const double eps = 1e-6;
-    for (int i = 0; i < n_attempts; ++i)
+public:
+    PatchLocator(
+            const std::vector<pm::face_handle>& _t_patch,
+            const pm::vertex_attribute<tg::pos3>& _pos,
+            const HalfedgeParam& _param) :
+        pos(_pos)
     {
+        LE_ASSERT(!_t_patch.empty());
+
+        triangles.reserve(_t_patch.size());
+        std::vector<tg::daabb2> bbs;
+        bbs.reserve(_t_patch.size());
         for (auto t_f : _t_patch)
         {
             LE_ASSERT_EQ(t_f.halfedges().size(), 3);
-            const auto ha = t_f.halfedges().first(); // pointing to vertex a
-            const auto hb = ha.next(); // pointing to vertex b
-            const auto hc = hb.next(); // pointing to vertex c
+            Triangle tri;
+            tri.ha = t_f.halfedges().first(); // pointing to vertex a
+            tri.hb = tri.ha.next(); // pointing to vertex b
+            tri.hc = tri.hb.next(); // pointing to vertex c
+            tri.a = _param[tri.ha];
+            tri.b = _param[tri.hb];
+            tri.c = _param[tri.hc];
+            triangles.push_back(tri);
+
+            // Pad the triangle bounds, so that the slightly enlarged triangles
+            // of repeated lookups (see point_on_surface) are still found in their cells.
+            tg::daabb2 bb;
+            bb.min = tg::dpos2(std::min({tri.a.x, tri.b.x, tri.c.x}), std::min({tri.a.y, tri.b.y, tri.c.y}));
+            bb.max = tg::dpos2(std::max({tri.a.x, tri.b.x, tri.c.x}), std::max({tri.a.y, tri.b.y, tri.c.y}));
+            const auto pad = 1e-5 * (bb.max - bb.min) + tg::dvec2(1e-12, 1e-12);
+            bb.min -= pad;
+            bb.max += pad;
+            bbs.push_back(bb);
+
+            if (bbs.size() == 1)
+                bounds = bb;
+            bounds.min = tg::dpos2(std::min(bounds.min.x, bb.min.x), std::min(bounds.min.y, bb.min.y));
+            bounds.max = tg::dpos2(std::max(bounds.max.x, bb.max.x), std::max(bounds.max.y, bb.max.y));
+        }
+
+        // Roughly one triangle per cell
+        const auto extent = bounds.max - bounds.min;
+        const double cell_size = std::sqrt(extent.x * extent.y / triangles.size());
+        if (std::isfinite(cell_size) && cell_size > 0.0)
+        {
+            n_cells_x = std::clamp((int)std::ceil(extent.x / cell_size), 1, 1024);
+            n_cells_y = std::clamp((int)std::ceil(extent.y / cell_size), 1, 1024);
+        }
+
+        // Bin triangles (two passes: count, then fill)
+        cell_begin.assign(n_cells_x * n_cells_y + 1, 0);
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            std::vector<int> fill;
+            if (pass == 1)
+            {
+                for (int i = 1; i < (int)cell_begin.size(); ++i)
+                    cell_begin[i] += cell_begin[i - 1];
+                cell_triangles.resize(cell_begin.back());
+                fill.assign(cell_begin.begin(), cell_begin.end() - 1);
+            }
+
+            for (int t = 0; t < (int)triangles.size(); ++t)
+            {
+                const auto [x_min, y_min] = cell_coords(bbs[t].min);
+                const auto [x_max, y_max] = cell_coords(bbs[t].max);
+                for (int y = y_min; y <= y_max; ++y)
+                {
+                    for (int x = x_min; x <= x_max; ++x)
+                    {
+                        const int cell = y * n_cells_x + x;
+                        if (pass == 0)
+                            ++cell_begin[cell + 1];
+                        else
+                            cell_triangles[fill[cell]++] = t;
+                    }
+                }
+            }
+        }
+    }
 
-            if (in_triangle_inclusive(_p, _param[ha], _param[hb], _param[hc], scale))
+    /// Returns the surface point at parameter _p.
+    /// _hint is the index of the triangle that is tested first. It is updated to the triangle that contained _p.
+    /// Use -1 if no hint is available.
+    tg::pos3 point_on_surface(
+            const tg::dpos2& _p,
+            int& _hint) const
+    {
+        // To fix numerical issues at the patch boundary,
+        // try the lookup a few times while slowly growing each individual triangle.
+        const int n_attempts = 3;
+        double scale = 1.0;
+        const double eps = 1e-6;
+        for (int i = 0; i < n_attempts; ++i)
+        {
+            if (_hint >= 0 && contains(triangles[_hint], _p, scale))
+                return interpolate(triangles[_hint], _p);
+
+            if (inside_bounds(_p))
             {
-                auto [alpha, beta] = compute_bary(_p, _param[ha], _param[hb], _param[hc]);
-                if (!std::isfinite(alpha) || !std::isfinite(beta))
+                const auto [x, y] = cell_coords(_p);
+                const int cell = y * n_cells_x + x;
+                for (int j = cell_begin[cell]; j < cell_begin[cell + 1]; ++j)
                 {
-                    alpha = 1.0 / 3.0;
-                    beta = 1.0 / 3.0;
-//                    std::cout << "Computing barycentric coordinates failed due to degenerate triangle." << std::endl;
+                    const int t = cell_triangles[j];
+                    if (contains(triangles[t], _p, scale))
+                    {
+                        _hint = t;
+                        return interpolate(triangles[t], _p);
+                    }
                 }
-                return alpha * _pos[ha.vertex_to()] + beta * _pos[hb.vertex_to()] + (1.0 - alpha - beta) * _pos[hc.vertex_to()];
             }
+
+            scale *= 1.0 + eps;
         }
 
-        scale *= 1.0 + eps;
+        LE_ERROR_THROW("Triangle lookup failed");
+    }
+
+private:
+    struct Triangle
+    {
+        pm::halfedge_handle ha;
+        pm::halfedge_handle hb;
+        pm::halfedge_handle hc;
+        tg::dpos2 a;
+        tg::dpos2 b;
+        tg::dpos2 c;
+    };
+
+    const pm::vertex_attribute<tg::pos3>& pos;
+    std::vector<Triangle> triangles;
+
+    tg::daabb2 bounds;
+    int n_cells_x = 1;
+    int n_cells_y = 1;
+    std::vector<int> cell_begin; // Per cell, plus one. Ranges into cell_triangles.
+    std::vector<int> cell_triangles;
+
+    bool inside_bounds(const tg::dpos2& _p) const
+    {
+        return _p.x >= bounds.min.x && _p.x <= bounds.max.x &&
+               _p.y >= bounds.min.y && _p.y <= bounds.max.y;
     }
 
-    LE_ERROR_THROW("Triangle lookup failed");
+    std::pair<int, int> cell_coords(const tg::dpos2& _p) const
+    {
+        const double rel_x = (_p.x - bounds.min.x) / (bounds.max.x - bounds.min.x);
+        const double rel_y = (_p.y - bounds.min.y) / (bounds.max.y - bounds.min.y);
+        const int x = std::clamp((int)(rel_x * n_cells_x), 0, n_cells_x - 1);
+        const int y = std::clamp((int)(rel_y * n_cells_y), 0, n_cells_y - 1);
+        return { x, y };
+    }
+
+    static bool contains(const Triangle& _tri, const tg::dpos2& _p, const double _scale)
+    {
+        return in_triangle_inclusive(_p, _tri.a, _tri.b, _tri.c, _scale);
+    }
+
+    tg::pos3 interpolate(const Triangle& _tri, const tg::dpos2& _p) const
+    {
+        auto [alpha, beta] = compute_bary(_p, _tri.a, _tri.b, _tri.c);
+        if (!std::isfinite(alpha) || !std::isfinite(beta))
+        {
+            alpha = 1.0 / 3.0;
+            beta = 1.0 / 3.0;
+//            std::cout << "Computing barycentric coordinates failed due to degenerate triangle." << std::endl;
+        }
+        return alpha * pos[_tri.ha.vertex_to()] + beta * pos[_tri.hb.vertex_to()] + (1.0 - alpha - beta) * pos[_tri.hc.vertex_to()];
+    }
+};
+
+/// Integer grid points of a single patch, evaluated on the target surface
+struct PatchGrid
+{
+    pm::face_handle l_f;
+    int n_u = 0;
+    int n_v = 0;
+    std::vector<pm::face_handle> t_patch;
+
+    std::vector<tg::pos3> pos; // n_u x n_v, row-major
+    std::exception_ptr error;
+};
+
+/// Only reads the target mesh and the parametrization, can run concurrently for all patches.
+void evaluate_patch_grid(
+        const pm::vertex_attribute<tg::pos3>& _t_pos,
+        const HalfedgeParam& _param,
+        PatchGrid& _grid)
+{
+    try
+    {
+        const PatchLocator locator(_grid.t_patch, _t_pos, _param);
+        int hint = -1; // Neighboring grid points mostly lie in the same or an adjacent triangle
+
+        _grid.pos.resize(_grid.n_u * _grid.n_v);
+        for (int u = 0; u < _grid.n_u; ++u)
+        {
+            for (int v = 0; v < _grid.n_v; ++v)
+            {
+                const auto p_param = tg::dpos2((double)u, (double)v);
+                _grid.pos[u * _grid.n_v + v] = locator.point_on_surface(p_param, hint);
+            }
+        }
+    }
+    catch (...)
+    {
+        // Exceptions must not leave the parallel region
+        _grid.error = std::current_exception();
+    }
 }
 
 }
@@ -330,22 +562,47 @@ pm::vertex_attribute<tg::pos3> extract_quad_mesh(
     auto vv_cache = _em.layout_mesh().vertices().make_attribute<pm::vertex_handle>();
     auto hv_cache = _em.layout_mesh().halfedges().make_attribute<std::vector<pm::vertex_handle>>();
 
+    // Patch dimensions and target triangles (serial, get_patch builds the face regions of the Embedding on first use)
+    std::vector<PatchGrid> grids;
+    grids.reserve(_em.layout_mesh().faces().size());
     for (auto l_f : _em.layout_mesh().faces())
     {
-        // Determine patch dimensions
+        PatchGrid grid;
+        grid.l_f = l_f;
+
+        // First halfedge defines u direction
+        const auto l_h_u = l_f.halfedges().first();
+        const auto l_h_v = l_h_u.next();
+        grid.n_u = count_subdiv(_em, l_h_u, _param) + 2;
+        grid.n_v = count_subdiv(_em, l_h_v, _param) + 2;
+
+        grid.t_patch = _em.get_patch(l_f);
+        LE_ASSERT(!grid.t_patch.empty());
+
+        grids.push_back(std::move(grid));
+    }
+
+    // Evaluate grid point positions. Independent per patch.
+    #pragma omp parallel for schedule(dynamic)
+    for (int i = 0; i < (int)grids.size(); ++i)
+        evaluate_patch_grid(_em.target_pos(), _param, grids[i]);
+
+    // Assemble quad mesh serially, in layout face order
+    for (const auto& grid : grids)
+    {
+        if (grid.error)
+            std::rethrow_exception(grid.error);
+
+        const auto l_f = grid.l_f;
         const auto l_h_u = l_f.halfedges().first(); // u direction
         const auto l_h_v = l_h_u.next();
-        const int n_u = count_subdiv(_em, l_h_u, _param) + 2;
-        const int n_v = count_subdiv(_em, l_h_v, _param) + 2;
+        const int n_u = grid.n_u;
+        const int n_v = grid.n_v;
 
         // Per layout face, cache grid of vertex indices.
         // First halfedge defines u direction.
         std::vector<std::vector<pm::vertex_handle>> fv_cache(n_u, std::vector<pm::vertex_handle>(n_v));
 
-        // Get patch target triangles
-        const auto t_patch = _em.get_patch(l_f);
-        LE_ASSERT(!t_patch.empty());
-
         // Enumerate patch vertices
         for (int u = 0; u < n_u; ++u)
         {
@@ -434,9 +691,8 @@ pm::vertex_attribute<tg::pos3> extract_quad_mesh(
                     q_v = _q.vertices().add();
                 }
 
-                // Compute position
-                const auto p_param = tg::dpos2((double)u, (double)v);
-                q_pos[q_v] = point_on_surface(p_param, t_patch, _em.target_pos(), _param);
+                // Position
+                q_pos[q_v] = grid.pos[u * n_v + v];
 
                 // Add vertex to cache
                 fv_cache[u][v] = q_v;
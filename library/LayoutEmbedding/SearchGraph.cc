@@ -0,0 +1,194 @@
+#include "SearchGraph.hh"
+
+#include <LayoutEmbedding/Connectivity.hh>
+#include <LayoutEmbedding/Embedding.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+
+namespace LayoutEmbedding {
+
+namespace
+{
+
+/// Appends the neighbors of _t_vv in the same order in which the original handle-based search visited them.
+void collect_neighbors(const pm::Mesh& _t_m, const VirtualVertex& _t_vv, std::vector<int>& _out)
+{
+    if (is_real_vertex(_t_vv)) {
+        const auto t_v = real_vertex(_t_vv, _t_m);
+
+        // Incident vertices
+        for (const auto t_v_adj : t_v.adjacent_vertices()) {
+            _out.push_back(VirtualVertex(t_v_adj).unified_index());
+        }
+
+        // Incident edge midpoints
+        for (const auto t_he_out : t_v.outgoing_halfedges()) {
+            if (t_he_out.is_boundary()) {
+                continue;
+            }
+            _out.push_back(VirtualVertex(t_he_out.next().edge()).unified_index());
+        }
+    }
+    else {
+        const auto t_e = real_edge(_t_vv, _t_m);
+        const auto t_he = t_e.halfedgeA();
+        const auto t_he_opp = t_e.halfedgeB();
+
+        // Opposite vertices
+        if (!t_he.is_boundary()) {
+            _out.push_back(VirtualVertex(opposite_vertex(t_he)).unified_index());
+        }
+        if (!t_he_opp.is_boundary()) {
+            _out.push_back(VirtualVertex(opposite_vertex(t_he_opp)).unified_index());
+        }
+
+        // Incident edges
+        if (!t_he.is_boundary()) {
+            _out.push_back(VirtualVertex(t_he.next().edge()).unified_index());
+            _out.push_back(VirtualVertex(t_he.prev().edge()).unified_index());
+        }
+        if (!t_he_opp.is_boundary()) {
+            _out.push_back(VirtualVertex(t_he_opp.prev().edge()).unified_index());
+            _out.push_back(VirtualVertex(t_he_opp.next().edge()).unified_index());
+        }
+    }
+}
+
+}
+
+void SearchGraph::build(const Embedding& _em)
+{
+    const auto& t_m = _em.target_mesh();
+
+    node_arcs.clear();
+    node_pos.clear();
+    node_blocked.clear();
+    arc_head.clear();
+    arc_length.clear();
+    num_garbage_arcs = 0;
+
+    resize(t_m);
+    arc_head.reserve(6 * t_m.halfedges().size());
+    arc_length.reserve(6 * t_m.halfedges().size());
+
+    // Positions have to be known before arc lengths can be computed
+    for (const auto t_v : t_m.vertices()) {
+        update_node_pos(_em, t_v);
+    }
+    for (const auto t_e : t_m.edges()) {
+        update_node_pos(_em, t_e);
+    }
+
+    for (const auto t_v : t_m.vertices()) {
+        update_node_arcs(_em, t_v);
+        update_blocked(_em, t_v);
+    }
+    for (const auto t_e : t_m.edges()) {
+        update_node_arcs(_em, t_e);
+        update_blocked(_em, t_e);
+    }
+}
+
+void SearchGraph::update_blocked(const Embedding& _em, const VirtualVertex& _t_vv)
+{
+    LE_ASSERT_L(_t_vv.unified_index(), num_nodes());
+    node_blocked[_t_vv.unified_index()] = _em.is_blocked(_t_vv);
+}
+
+void SearchGraph::update_after_splits(const Embedding& _em, const std::vector<pm::vertex_handle>& _t_v_new)
+{
+    const auto& t_m = _em.target_mesh();
+    resize(t_m);
+
+    // Every face created by the splits contains at least one of the new vertices.
+    // Thus, all nodes whose neighborhood (or position) changed are elements of the faces around them.
+    std::vector<VirtualVertex> affected;
+    for (const auto& t_v : _t_v_new) {
+        LE_ASSERT(t_v.mesh == &t_m);
+        for (const auto t_f : t_v.faces()) {
+            if (t_f.is_invalid()) {
+                continue;
+            }
+            for (const auto t_v_f : t_f.vertices()) {
+                affected.push_back(t_v_f);
+            }
+            for (const auto t_e_f : t_f.edges()) {
+                affected.push_back(t_e_f);
+            }
+        }
+    }
+    std::sort(affected.begin(), affected.end());
+    affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+    for (const auto& vv : affected) {
+        update_node_pos(_em, vv);
+    }
+    for (const auto& vv : affected) {
+        update_node_arcs(_em, vv);
+        update_blocked(_em, vv);
+    }
+
+    if (2 * num_garbage_arcs > (int)arc_head.size()) {
+        compact();
+    }
+}
+
+int SearchGraph::num_nodes() const
+{
+    return node_arcs.size();
+}
+
+void SearchGraph::resize(const pm::Mesh& _t_m)
+{
+    const int n = virtual_vertex_index_bound(_t_m);
+    if (n > num_nodes()) {
+        node_arcs.resize(n);
+        node_pos.resize(n);
+        node_blocked.resize(n, true);
+    }
+}
+
+void SearchGraph::update_node_pos(const Embedding& _em, const VirtualVertex& _t_vv)
+{
+    LE_ASSERT_L(_t_vv.unified_index(), num_nodes());
+    node_pos[_t_vv.unified_index()] = _em.element_pos(_t_vv);
+}
+
+void SearchGraph::update_node_arcs(const Embedding& _em, const VirtualVertex& _t_vv)
+{
+    LE_ASSERT_L(_t_vv.unified_index(), num_nodes());
+    auto& range = node_arcs[_t_vv.unified_index()];
+    num_garbage_arcs += range.end - range.begin;
+
+    range.begin = arc_head.size();
+    collect_neighbors(_em.target_mesh(), _t_vv, arc_head);
+    range.end = arc_head.size();
+
+    const auto& p = node_pos[_t_vv.unified_index()];
+    for (int a = range.begin; a < range.end; ++a) {
+        arc_length.push_back(tg::distance(p, node_pos[arc_head[a]]));
+    }
+}
+
+void SearchGraph::compact()
+{
+    std::vector<int> new_arc_head;
+    std::vector<float> new_arc_length;
+    new_arc_head.reserve(arc_head.size() - num_garbage_arcs);
+    new_arc_length.reserve(arc_head.size() - num_garbage_arcs);
+
+    for (auto& range : node_arcs) {
+        const int new_begin = new_arc_head.size();
+        new_arc_head.insert(new_arc_head.end(), arc_head.begin() + range.begin, arc_head.begin() + range.end);
+        new_arc_length.insert(new_arc_length.end(), arc_length.begin() + range.begin, arc_length.begin() + range.end);
+        range.begin = new_begin;
+        range.end = new_arc_head.size();
+    }
+
+    arc_head = std::move(new_arc_head);
+    arc_length = std::move(new_arc_length);
+    num_garbage_arcs = 0;
+}
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <LayoutEmbedding/VirtualVertex.hh>
+
+#include <polymesh/pm.hh>
+#include <typed-geometry/tg-lean.hh>
+
+#include <vector>
+
+namespace LayoutEmbedding {
+
+class Embedding;
+
+/// Flat snapshot of the virtual vertex graph of an Embedding's target mesh, used by the path search.
+/// Nodes are VirtualVertices, addressed by VirtualVertex::unified_index().
+/// Neighbors of a vertex are its adjacent vertices and the opposite edges in its incident faces.
+/// Neighbors of an edge are its two opposite vertices and the other edges of its incident faces.
+/// Adjacency lists are stored contiguously (CSR) together with precomputed arc lengths.
+///
+/// Local updates (after edge splits) append the new adjacency lists of all affected nodes at the end
+/// of the arc arrays. The old lists are left behind as garbage, which is reclaimed by compaction
+/// once it makes up half of the arc storage.
+struct SearchGraph
+{
+    struct ArcRange
+    {
+        int begin = 0;
+        int end = 0;
+    };
+
+    // Per node
+    std::vector<ArcRange> node_arcs;
+    std::vector<tg::pos3> node_pos;
+    std::vector<char> node_blocked;
+
+    // Per arc
+    std::vector<int> arc_head; // Unified index of the target node
+    std::vector<float> arc_length; // Same value as tg::distance() between the element positions
+
+    int num_garbage_arcs = 0;
+
+    /// Builds the graph from scratch.
+    void build(const Embedding& _em);
+
+    /// Re-evaluates the blocked flag of a single node, e.g. after (un)embedding a path through it.
+    void update_blocked(const Embedding& _em, const VirtualVertex& _t_vv);
+
+    /// Updates all nodes whose neighborhood, position or blocked state might have changed
+    /// by splitting edges, given the vertices that were inserted by these splits.
+    void update_after_splits(const Embedding& _em, const std::vector<pm::vertex_handle>& _t_v_new);
+
+    int num_nodes() const;
+
+private:
+    void resize(const pm::Mesh& _t_m);
+    void update_node_pos(const Embedding& _em, const VirtualVertex& _t_vv);
+    void update_node_arcs(const Embedding& _em, const VirtualVertex& _t_vv);
+    void compact();
+};
+
+}
@@ -0,0 +1,314 @@
+#include "SyntheticWorkload.hh"
+
+#include <LayoutEmbedding/LayoutGeneration.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <random>
+
+namespace LayoutEmbedding {
+
+namespace
+{
+
+/// Uniform in [0, 1). Unlike std::uniform_real_distribution, the sequence is the same for all standard libraries.
+double uniform(std::mt19937& _rng)
+{
+    return _rng() / 4294967296.0;
+}
+
+double uniform(std::mt19937& _rng, const double _min, const double _max)
+{
+    return _min + (_max - _min) * uniform(_rng);
+}
+
+tg::dvec3 uniform_direction(std::mt19937& _rng)
+{
+    while (true) {
+        const tg::dvec3 d(uniform(_rng, -1.0, 1.0), uniform(_rng, -1.0, 1.0), uniform(_rng, -1.0, 1.0));
+        const double l = tg::length(d);
+        if (l > 1e-3 && l <= 1.0) {
+            return d / l;
+        }
+    }
+}
+
+/// Positions and triangles of a closed mesh
+struct TriangleSoup
+{
+    std::vector<tg::dpos3> pos;
+    std::vector<std::array<int, 3>> faces;
+};
+
+/// Class I geodesic sphere of frequency _f: Each icosahedron face is split into _f^2 triangles,
+/// whose vertices are projected to the unit sphere. Has 10 _f^2 + 2 vertices.
+TriangleSoup geodesic_sphere(const int _f)
+{
+    LE_ASSERT_GEQ(_f, 1);
+
+    const double t = (1.0 + std::sqrt(5.0)) / 2.0;
+    const std::vector<tg::dvec3> corners = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+    };
+    const std::vector<std::array<int, 3>> ico_faces = {
+        {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+        {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+        {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+        {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1},
+    };
+
+    TriangleSoup soup;
+    soup.pos.reserve(10 * (size_t)_f * _f + 2);
+    soup.faces.reserve(20 * (size_t)_f * _f);
+
+    // Point at barycentric grid coordinates (_i, _j) of a face, i.e. _i steps towards _b and _j steps towards _c
+    auto grid_point = [&] (const int _a, const int _b, const int _c, const int _i, const int _j) {
+        const tg::dvec3 p = corners[_a] * (double)(_f - _i - _j) + corners[_b] * (double)_i + corners[_c] * (double)_j;
+        return tg::dpos3(tg::normalize(p));
+    };
+
+    for (int i = 0; i < 12; ++i) {
+        soup.pos.push_back(tg::dpos3(tg::normalize(corners[i])));
+    }
+
+    // Vertices in the interior of the icosahedron edges, ordered from the smaller to the larger corner index
+    std::map<std::pair<int, int>, int> edge_base;
+    for (const auto& f : ico_faces) {
+        for (int k = 0; k < 3; ++k) {
+            const int u = std::min(f[k], f[(k + 1) % 3]);
+            const int v = std::max(f[k], f[(k + 1) % 3]);
+            if (edge_base.count({u, v})) {
+                continue;
+            }
+            edge_base[{u, v}] = soup.pos.size();
+            for (int s = 1; s < _f; ++s) {
+                soup.pos.push_back(grid_point(u, v, v, s, 0));
+            }
+        }
+    }
+    auto edge_vertex = [&] (const int _u, const int _v, const int _s) { // _s steps from _u towards _v
+        return _u < _v ? edge_base.at({_u, _v}) + _s - 1 : edge_base.at({_v, _u}) + (_f - _s) - 1;
+    };
+
+    std::vector<int> grid((_f + 1) * (_f + 1));
+    for (const auto& f : ico_faces) {
+        const int a = f[0];
+        const int b = f[1];
+        const int c = f[2];
+        for (int j = 0; j <= _f; ++j) {
+            for (int i = 0; i + j <= _f; ++i) {
+                int idx;
+                if (i == 0 && j == 0) {
+                    idx = a;
+                }
+                else if (i == _f) {
+                    idx = b;
+                }
+                else if (j == _f) {
+                    idx = c;
+                }
+                else if (j == 0) {
+                    idx = edge_vertex(a, b, i);
+                }
+                else if (i == 0) {
+                    idx = edge_vertex(a, c, j);
+                }
+                else if (i + j == _f) {
+                    idx = edge_vertex(b, c, j);
+                }
+                else {
+                    idx = soup.pos.size();
+                    soup.pos.push_back(grid_point(a, b, c, i, j));
+                }
+                grid[j * (_f + 1) + i] = idx;
+            }
+        }
+
+        auto g = [&] (const int _i, const int _j) { return grid[_j * (_f + 1) + _i]; };
+        for (int j = 0; j < _f; ++j) {
+            for (int i = 0; i + j < _f; ++i) {
+                soup.faces.push_back({g(i, j), g(i + 1, j), g(i, j + 1)});
+                if (i + j + 1 < _f) {
+                    soup.faces.push_back({g(i + 1, j), g(i + 1, j + 1), g(i, j + 1)});
+                }
+            }
+        }
+    }
+
+    LE_ASSERT_EQ(soup.pos.size(), 10 * (size_t)_f * _f + 2);
+    return soup;
+}
+
+/// Torus around the z-axis with (major) radius 1, built from a regular grid of _n_u x _n_v quads.
+TriangleSoup torus(const int _n_u, const int _n_v, const double _minor_radius)
+{
+    LE_ASSERT_GEQ(_n_u, 3);
+    LE_ASSERT_GEQ(_n_v, 3);
+
+    TriangleSoup soup;
+    soup.pos.reserve((size_t)_n_u * _n_v);
+    soup.faces.reserve(2 * (size_t)_n_u * _n_v);
+    for (int i = 0; i < _n_u; ++i) {
+        const double u = 2.0 * M_PI * i / _n_u;
+        for (int j = 0; j < _n_v; ++j) {
+            const double v = 2.0 * M_PI * j / _n_v;
+            const double r = 1.0 + _minor_radius * std::cos(v);
+            soup.pos.push_back({r * std::cos(u), r * std::sin(u), _minor_radius * std::sin(v)});
+        }
+    }
+
+    auto idx = [&] (const int _i, const int _j) { return (_i % _n_u) * _n_v + (_j % _n_v); };
+    for (int i = 0; i < _n_u; ++i) {
+        for (int j = 0; j < _n_v; ++j) {
+            soup.faces.push_back({idx(i, j), idx(i + 1, j), idx(i + 1, j + 1)});
+            soup.faces.push_back({idx(i, j), idx(i + 1, j + 1), idx(i, j + 1)});
+        }
+    }
+    return soup;
+}
+
+/// Displaces the vertices of the unit sphere radially by a sum of _n_bumps Gaussian bumps at random positions.
+void add_bumps(TriangleSoup& _soup, const int _n_bumps, std::mt19937& _rng)
+{
+    struct Bump
+    {
+        tg::dvec3 center;
+        double height;
+        double width; // Angle (standard deviation)
+    };
+    std::vector<Bump> bumps;
+    for (int i = 0; i < _n_bumps; ++i) {
+        Bump b;
+        b.center = uniform_direction(_rng);
+        b.height = uniform(_rng, 0.05, 0.3);
+        b.width = uniform(_rng, 0.15, 0.45);
+        bumps.push_back(b);
+    }
+
+    #pragma omp parallel for
+    for (int i = 0; i < (int)_soup.pos.size(); ++i) {
+        const tg::dvec3 d(_soup.pos[i]);
+        double r = 1.0;
+        for (const auto& b : bumps) {
+            const double angle = std::acos(std::clamp(tg::dot(d, b.center), -1.0, 1.0));
+            r += b.height * std::exp(-0.5 * (angle * angle) / (b.width * b.width));
+        }
+        _soup.pos[i] = tg::dpos3(r * d);
+    }
+}
+
+/// Stretches the unit sphere along the x-axis and pinches it in the middle (peanut shape).
+void elongate(TriangleSoup& _soup)
+{
+    const double length = 2.5;
+    const double waist = 0.5; // Relative reduction of the radius at x = 0
+
+    #pragma omp parallel for
+    for (int i = 0; i < (int)_soup.pos.size(); ++i) {
+        const auto& p = _soup.pos[i];
+        const double w = 1.0 - waist * std::exp(-(p.x * p.x) / 0.08);
+        _soup.pos[i] = tg::dpos3(length * p.x, w * p.y, w * p.z);
+    }
+}
+
+void build_mesh(const TriangleSoup& _soup, pm::Mesh& _m, pm::vertex_attribute<tg::pos3>& _pos)
+{
+    _m.clear();
+    _m.vertices().reserve(_soup.pos.size());
+    _m.faces().reserve(_soup.faces.size());
+    _m.halfedges().reserve(3 * _soup.faces.size());
+    _m.edges().reserve(3 * _soup.faces.size() / 2);
+
+    for (const auto& p : _soup.pos) {
+        const auto v = _m.vertices().add();
+        _pos[v] = tg::pos3(p);
+    }
+    const auto vertices = _m.vertices();
+    for (const auto& f : _soup.faces) {
+        _m.faces().add(vertices[f[0]], vertices[f[1]], vertices[f[2]]);
+    }
+}
+
+}
+
+std::string to_string(const SyntheticShape _shape)
+{
+    switch (_shape) {
+        case SyntheticShape::Sphere: return "sphere";
+        case SyntheticShape::Torus: return "torus";
+        case SyntheticShape::Bumpy: return "bumpy";
+        case SyntheticShape::Elongated: return "elongated";
+    }
+    LE_ERROR_THROW("Unknown shape");
+}
+
+bool parse_synthetic_shape(const std::string& _s, SyntheticShape& _shape)
+{
+    for (const auto shape : { SyntheticShape::Sphere, SyntheticShape::Torus, SyntheticShape::Bumpy, SyntheticShape::Elongated }) {
+        if (_s == to_string(shape)) {
+            _shape = shape;
+            return true;
+        }
+    }
+    return false;
+}
+
+void make_synthetic_target(EmbeddingInput& _input, const SyntheticShape _shape, const int _n_vertices, const int _seed)
+{
+    LE_ASSERT_G(_n_vertices, 0);
+
+    std::mt19937 rng(_seed);
+    TriangleSoup soup;
+    if (_shape == SyntheticShape::Torus) {
+        // Roughly square grid cells: n_u / n_v = major / minor radius
+        const double minor_radius = 0.35;
+        const int n_v = std::max(3, (int)std::lround(std::sqrt(_n_vertices * minor_radius)));
+        const int n_u = std::max(3, (int)std::lround((double)_n_vertices / n_v));
+        soup = torus(n_u, n_v, minor_radius);
+    }
+    else {
+        const int f = std::max(1, (int)std::lround(std::sqrt((_n_vertices - 2) / 10.0)));
+        soup = geodesic_sphere(f);
+        if (_shape == SyntheticShape::Bumpy) {
+            add_bumps(soup, 16, rng);
+        }
+        else if (_shape == SyntheticShape::Elongated) {
+            elongate(soup);
+        }
+    }
+
+    build_mesh(soup, _input.t_m, _input.t_pos);
+}
+
+int layout_vertices_for_edges(const pm::Mesh& _m, const int _n_edges)
+{
+    // Closed triangle meshes: E = 3 (V - χ)
+    const int chi = pm::euler_characteristic(_m);
+    const int n_vertices = (int)std::lround(_n_edges / 3.0) + chi;
+
+    // Lower bound on the vertex count of a triangulation (Heawood)
+    const int min_vertices = (int)std::ceil((7.0 + std::sqrt(49.0 - 24.0 * chi)) / 2.0);
+    return std::max(n_vertices, min_vertices);
+}
+
+void make_synthetic_workload(EmbeddingInput& _input, const SyntheticWorkloadSettings& _settings)
+{
+    make_synthetic_target(_input, _settings.shape, _settings.target_vertices, _settings.seed);
+    make_layout_by_decimation(_input, layout_vertices_for_edges(_input.t_m, _settings.layout_edges));
+    find_matching_vertices_by_proximity(_input);
+    if (_settings.jitter_steps > 0) {
+        jitter_matching_vertices(_input, _settings.jitter_steps, _settings.seed);
+    }
+
+    std::cout << "Synthetic workload (" << to_string(_settings.shape) << ", seed " << _settings.seed << "): "
+              << _input.t_m.vertices().size() << " target vertices, "
+              << _input.l_m.vertices().size() << " layout vertices, "
+              << _input.l_m.edges().size() << " layout edges." << std::endl;
+}
+
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <LayoutEmbedding/EmbeddingInput.hh>
+
+#include <string>
+
+namespace LayoutEmbedding {
+
+/// Parametric target surfaces for benchmarks and scaling studies.
+enum class SyntheticShape
+{
+    Sphere,    // Geodesic sphere (icosahedron with subdivided faces)
+    Torus,     // Genus 1
+    Bumpy,     // Sphere with random radial bumps
+    Elongated, // Sphere stretched along x, with a waist in the middle
+};
+
+std::string to_string(const SyntheticShape _shape);
+bool parse_synthetic_shape(const std::string& _s, SyntheticShape& _shape);
+
+struct SyntheticWorkloadSettings
+{
+    SyntheticShape shape = SyntheticShape::Sphere;
+    int target_vertices = 10000; // Approximate. The mesh resolution is adjusted in discrete steps.
+    int layout_edges = 42; // Approximate. Rounded to the nearest layout vertex count.
+    int jitter_steps = 0; // See jitter_matching_vertices
+    int seed = 0; // Bump placement (Bumpy) and landmark jitter
+};
+
+/// Creates a closed triangle mesh of the given shape with about _n_vertices vertices.
+/// This will overwrite the _input's target mesh t_m. The result only depends on the arguments.
+void make_synthetic_target(EmbeddingInput& _input, const SyntheticShape _shape, const int _n_vertices, const int _seed = 0);
+
+/// Number of vertices of a closed triangle layout with (about) _n_edges edges and the topology of the mesh _m.
+int layout_vertices_for_edges(const pm::Mesh& _m, const int _n_edges);
+
+/// Creates a complete embedding input: synthetic target mesh, a layout decimated from it and landmarks.
+/// Landmarks are the target vertices closest to the layout vertices, optionally jittered.
+void make_synthetic_workload(EmbeddingInput& _input, const SyntheticWorkloadSettings& _settings);
+
+}
@@ -4,6 +4,8 @@
 
 #include <cmath>
 #include <iostream>
+#include <sstream>
+#include <stdexcept>
 
 #define LE_ERROR(str) \
     std::cout \
@@ -12,10 +14,13 @@
     << " (in function " << __FUNCTION__ << ", " << __FILE__ << ":" << __LINE__ << ")" \
     << std::endl
 
-#define LE_ERROR_THROW(str) \
-    {LE_ERROR(str); \
+// The message is kept in the exception, so callers that catch it (e.g. embed_batch) can report it.
+#define LE_ERROR_THROW(msg) \
+    {std::ostringstream le_error_message; \
+    le_error_message << msg << " (in function " << __FUNCTION__ << ", " << __FILE__ << ":" << __LINE__ << ")"; \
+    std::cout << "[ERROR] " << le_error_message.str() << std::endl; \
     print_stack_trace(); \
-    throw std::runtime_error("ERROR");}
+    throw std::runtime_error(le_error_message.str());}
 
 #define LE_ASSERT(exp) \
     {if (!(exp)) LE_ERROR_THROW("Assertion failed: " #exp);}
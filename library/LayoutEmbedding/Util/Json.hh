@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+/// Minimal helpers for the line-based JSON reports written by the command line tools (embed_batch, layout_embedding_bench).
+/// Only flat objects with string and number values on a single line are supported when reading.
+
+namespace LayoutEmbedding
+{
+
+/// Quoted and escaped JSON string.
+inline std::string json_string(const std::string& _s)
+{
+    std::ostringstream ss;
+    ss << '"';
+    for (const char c : _s) {
+        switch (c) {
+            case '"': ss << "\\\""; break;
+            case '\\': ss << "\\\\"; break;
+            case '\n': ss << "\\n"; break;
+            case '\t': ss << "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c << std::dec;
+                }
+                else {
+                    ss << c;
+                }
+        }
+    }
+    ss << '"';
+    return ss.str();
+}
+
+/// JSON number that round-trips exactly. null for inf and nan.
+inline std::string json_number(const double _x)
+{
+    if (!std::isfinite(_x)) {
+        return "null";
+    }
+    std::ostringstream ss;
+    ss << std::setprecision(std::numeric_limits<double>::max_digits10) << _x;
+    return ss.str();
+}
+
+/// Value of a field in a report line written via the functions above.
+/// Strings are unescaped, other values are returned verbatim. Empty if not present.
+inline std::string read_json_field(const std::string& _line, const std::string& _key)
+{
+    const std::string prefix = "\"" + _key + "\":";
+    const auto pos = _line.find(prefix);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    size_t i = pos + prefix.size();
+    std::string result;
+    if (i < _line.size() && _line[i] == '"') {
+        for (++i; i < _line.size() && _line[i] != '"'; ++i) {
+            if (_line[i] == '\\' && i + 1 < _line.size()) {
+                ++i;
+            }
+            result += _line[i];
+        }
+    }
+    else {
+        for (; i < _line.size() && _line[i] != ',' && _line[i] != '}'; ++i) {
+            result += _line[i];
+        }
+    }
+    return result;
+}
+
+}
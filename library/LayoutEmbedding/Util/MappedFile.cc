@@ -0,0 +1,88 @@
+#include "MappedFile.hh"
+
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LE_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace LayoutEmbedding
+{
+
+MappedFile::MappedFile(const std::filesystem::path& _path)
+{
+    open(_path);
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const std::filesystem::path& _path)
+{
+    close();
+
+#ifdef LE_HAS_MMAP
+    const int fd = ::open(_path.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat st;
+        if (::fstat(fd, &st) == 0) {
+            len = st.st_size;
+            if (len == 0) {
+                opened = true;
+            }
+            else {
+                void* p = ::mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    ::madvise(p, len, MADV_SEQUENTIAL);
+                    ptr = static_cast<const char*>(p);
+                    mapped = true;
+                    opened = true;
+                }
+            }
+        }
+        ::close(fd);
+        if (opened) {
+            return true;
+        }
+        len = 0;
+    }
+#endif
+
+    std::ifstream file(_path, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    buffer.resize(file.tellg());
+    file.seekg(0);
+    if (!file.read(buffer.data(), buffer.size())) {
+        buffer.clear();
+        return false;
+    }
+    ptr = buffer.data();
+    len = buffer.size();
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef LE_HAS_MMAP
+    if (mapped) {
+        ::munmap(const_cast<char*>(ptr), len);
+    }
+#endif
+    buffer.clear();
+    buffer.shrink_to_fit();
+    opened = false;
+    mapped = false;
+    ptr = nullptr;
+    len = 0;
+}
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <vector>
+
+namespace LayoutEmbedding
+{
+
+/// Read-only view of a whole file.
+/// Memory-mapped where supported, so the contents are paged in on access instead of being copied.
+/// Falls back to reading the file into memory otherwise.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::filesystem::path& _path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::filesystem::path& _path);
+    void close();
+
+    bool is_open() const { return opened; }
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+
+private:
+    bool opened = false;
+    bool mapped = false;
+    const char* ptr = nullptr;
+    size_t len = 0;
+    std::vector<char> buffer; // Fallback
+};
+
+}
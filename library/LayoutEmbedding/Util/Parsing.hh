@@ -0,0 +1,178 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+/// Minimal parsing primitives for text files held in memory (e.g. a MappedFile).
+/// Buffers are given as [p, end) and need not be null-terminated.
+/// Tokens are separated by spaces, tabs or carriage returns. '\n' ends a line and is never skipped implicitly.
+
+namespace LayoutEmbedding
+{
+
+inline bool is_blank(const char _c)
+{
+    return _c == ' ' || _c == '\t' || _c == '\r';
+}
+
+inline bool is_digit(const char _c)
+{
+    return _c >= '0' && _c <= '9';
+}
+
+inline const char* skip_blanks(const char* _p, const char* _end)
+{
+    while (_p < _end && is_blank(*_p)) {
+        ++_p;
+    }
+    return _p;
+}
+
+/// Beginning of the next line (or _end).
+inline const char* next_line(const char* _p, const char* _end)
+{
+    const void* nl = std::memchr(_p, '\n', _end - _p);
+    return nl ? static_cast<const char*>(nl) + 1 : _end;
+}
+
+/// End of the token starting at _p (first blank, line break or '/').
+inline const char* token_end(const char* _p, const char* _end)
+{
+    while (_p < _end && !is_blank(*_p) && *_p != '\n' && *_p != '/') {
+        ++_p;
+    }
+    return _p;
+}
+
+/// True if only blanks or a '#' comment remain on the line.
+inline bool at_line_end(const char* _p, const char* _end)
+{
+    _p = skip_blanks(_p, _end);
+    return _p == _end || *_p == '\n' || *_p == '#';
+}
+
+/// Parses a (signed) decimal integer after optional blanks and advances _p past it.
+inline bool parse_int(const char*& _p, const char* _end, int& _value)
+{
+    const char* p = skip_blanks(_p, _end);
+    bool negative = false;
+    if (p < _end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+    if (p == _end || !is_digit(*p)) {
+        return false;
+    }
+    int64_t v = 0;
+    while (p < _end && is_digit(*p)) {
+        v = v * 10 + (*p - '0');
+        if (v > INT32_MAX) {
+            return false;
+        }
+        ++p;
+    }
+    _value = negative ? -(int)v : (int)v;
+    _p = p;
+    return true;
+}
+
+/// Parses a floating point number after optional blanks and advances _p past it.
+/// Correctly rounded, i.e. the result is identical to std::strtof.
+/// Short decimals are converted exactly in double arithmetic (see [Clinger1990]), everything else is passed on to std::strtof.
+inline bool parse_float(const char*& _p, const char* _end, float& _value)
+{
+    static constexpr double pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+    };
+
+    const char* start = skip_blanks(_p, _end);
+    const char* p = start;
+    bool negative = false;
+    if (p < _end && (*p == '-' || *p == '+')) {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    uint64_t mantissa = 0;
+    int num_digits = 0; // Significant digits in mantissa
+    int exponent = 0;
+    bool any_digits = false;
+    bool exact = true;
+    auto add_digit = [&] (const char _c) {
+        any_digits = true;
+        if (mantissa == 0 && _c == '0') {
+            return;
+        }
+        if (num_digits < 19) {
+            mantissa = mantissa * 10 + (_c - '0');
+            ++num_digits;
+        }
+        else {
+            exact = false;
+        }
+    };
+    while (p < _end && is_digit(*p)) {
+        add_digit(*p++);
+        if (!exact) {
+            ++exponent;
+        }
+    }
+    if (p < _end && *p == '.') {
+        ++p;
+        while (p < _end && is_digit(*p)) {
+            if (exact) {
+                add_digit(*p);
+                if (exact) {
+                    --exponent;
+                }
+            }
+            ++p;
+        }
+    }
+    if (any_digits && p < _end && (*p == 'e' || *p == 'E')) {
+        int e;
+        const char* q = p + 1;
+        if (q < _end && !is_blank(*q) && parse_int(q, _end, e)) {
+            exponent += e;
+            p = q;
+        }
+    }
+
+    if (any_digits && exact && num_digits <= 15 && exponent >= -22 && exponent <= 22) {
+        double v = (double)mantissa;
+        v = exponent < 0 ? v / pow10[-exponent] : v * pow10[exponent];
+
+        // v is the correctly rounded double. Rounding it to float is only wrong
+        // if v lies exactly halfway between two floats (double rounding).
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        const bool halfway = (bits & ((uint64_t(1) << 29) - 1)) == (uint64_t(1) << 28);
+        if (!halfway || v == 0.0) {
+            _value = negative ? -(float)v : (float)v;
+            _p = p;
+            return true;
+        }
+    }
+
+    // Slow path (long mantissas, large exponents, inf, nan, ...)
+    char buffer[128];
+    const char* end = token_end(start, _end);
+    const size_t len = end - start;
+    if (len == 0 || len >= sizeof(buffer)) {
+        return false;
+    }
+    std::memcpy(buffer, start, len);
+    buffer[len] = '\0';
+    char* buffer_end;
+    _value = std::strtof(buffer, &buffer_end);
+    if (buffer_end == buffer) {
+        return false;
+    }
+    _p = start + (buffer_end - buffer);
+    return true;
+}
+
+}
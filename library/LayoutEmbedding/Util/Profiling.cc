@@ -0,0 +1,198 @@
+#include "Profiling.hh"
+
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+namespace LayoutEmbedding
+{
+
+namespace profiling_detail
+{
+
+struct Node
+{
+    const char* name = "";
+    Node* parent = nullptr;
+
+    double seconds = 0.0;
+    int64_t calls = 0;
+    std::vector<std::pair<const char*, int64_t>> counters;
+    std::vector<std::unique_ptr<Node>> children;
+};
+
+}
+
+namespace
+{
+
+using profiling_detail::Node;
+
+struct ThreadData
+{
+    Node root;
+    Node* current = &root;
+};
+
+ThreadData& thread_data()
+{
+    thread_local ThreadData data;
+    return data;
+}
+
+/// Names are usually the same literal, so comparing pointers first avoids most string comparisons.
+bool same_name(const char* _a, const char* _b)
+{
+    return _a == _b || std::strcmp(_a, _b) == 0;
+}
+
+/// All allowed characters sort after '/', so paths of nested scopes sort right after their parent.
+bool valid_scope_name(const char* _name)
+{
+    if (*_name == '\0') {
+        return false;
+    }
+    for (const char* c = _name; *c != '\0'; ++c) {
+        if (!std::isalnum((unsigned char)*c) && *c != '_') {
+            return false;
+        }
+    }
+    return true;
+}
+
+void flatten(const Node& _node, const std::string& _path, Profile& _profile)
+{
+    if (_node.calls > 0 || !_node.counters.empty()) {
+        auto& entry = _profile.entries[_path];
+        entry.seconds = _node.seconds;
+        entry.calls = _node.calls;
+        for (const auto& [name, value] : _node.counters) {
+            entry.counters[name] += value;
+        }
+    }
+    for (const auto& child : _node.children) {
+        flatten(*child, _path.empty() ? child->name : _path + "/" + child->name, _profile);
+    }
+}
+
+}
+
+namespace profiling_detail
+{
+
+Node* enter(const char* _name)
+{
+    auto& data = thread_data();
+    Node* parent = data.current;
+    for (const auto& child : parent->children) {
+        if (same_name(child->name, _name)) {
+            data.current = child.get();
+            return data.current;
+        }
+    }
+    LE_ASSERT_MSG(valid_scope_name(_name), "Invalid scope name \"" << _name << "\"");
+    auto child = std::make_unique<Node>();
+    child->name = _name;
+    child->parent = parent;
+    data.current = child.get();
+    parent->children.push_back(std::move(child));
+    return data.current;
+}
+
+void leave(Node* _node, const double _seconds)
+{
+    auto& data = thread_data();
+    LE_ASSERT(data.current == _node);
+    _node->seconds += _seconds;
+    ++_node->calls;
+    data.current = _node->parent;
+}
+
+void count(const char* _name, const int64_t _n)
+{
+    auto& counters = thread_data().current->counters;
+    for (auto& counter : counters) {
+        if (same_name(counter.first, _name)) {
+            counter.second += _n;
+            return;
+        }
+    }
+    counters.push_back({_name, _n});
+}
+
+}
+
+Profile Profile::operator-(const Profile& _before) const
+{
+    Profile result;
+    for (const auto& [path, entry] : entries) {
+        ProfileEntry delta = entry;
+        const auto it = _before.entries.find(path);
+        if (it != _before.entries.end()) {
+            delta.seconds -= it->second.seconds;
+            delta.calls -= it->second.calls;
+            for (const auto& [name, value] : it->second.counters) {
+                delta.counters[name] -= value;
+            }
+        }
+
+        bool changed = delta.calls != 0;
+        for (auto c = delta.counters.begin(); c != delta.counters.end(); ) {
+            if (c->second == 0) {
+                c = delta.counters.erase(c);
+            }
+            else {
+                changed = true;
+                ++c;
+            }
+        }
+        if (changed) {
+            result.entries[path] = delta;
+        }
+    }
+    return result;
+}
+
+void Profile::print(std::ostream& _os) const
+{
+    _os << std::left << std::setw(48) << "Scope" << std::right << std::setw(12) << "Time [s]" << std::setw(12) << "Calls" << "  Counters" << std::endl;
+    for (const auto& [path, entry] : entries) {
+        const int depth = std::count(path.begin(), path.end(), '/');
+        const auto slash = path.rfind('/');
+        const std::string name = path.empty() ? "(no scope)" : (slash == std::string::npos ? path : path.substr(slash + 1));
+
+        std::ostringstream seconds;
+        seconds << std::fixed << std::setprecision(4) << entry.seconds;
+
+        _os << std::left << std::setw(48) << (std::string(2 * depth, ' ') + name) << std::right
+            << std::setw(12) << seconds.str()
+            << std::setw(12) << entry.calls << " ";
+        for (const auto& [counter, value] : entry.counters) {
+            _os << " " << counter << "=" << value;
+        }
+        _os << std::endl;
+    }
+}
+
+Profile thread_profile()
+{
+    Profile profile;
+    flatten(thread_data().root, "", profile);
+    return profile;
+}
+
+void reset_thread_profile()
+{
+    auto& data = thread_data();
+    LE_ASSERT(data.current == &data.root);
+    data.root.children.clear();
+    data.root.counters.clear();
+}
+
+}
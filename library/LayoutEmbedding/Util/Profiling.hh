@@ -0,0 +1,119 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+
+/// Hierarchical scoped timers and counters for the library hot paths.
+///
+///     LE_PROFILE_SCOPE("find_shortest_path");  // Times the enclosing block
+///     LE_PROFILE_COUNT("heap_pushes", n);      // Adds n to a counter of the innermost open scope
+///
+/// Scopes nest, so the same scope name is accounted separately per call site
+/// (e.g. "branch_and_bound/expand/find_shortest_path" vs. "embed_greedy/find_shortest_path").
+/// All data is accumulated per thread without synchronization.
+/// Work done on other threads (e.g. inside OpenMP parallel regions) is accounted to those threads.
+///
+/// Only active if the library is built with the CMake option LE_ENABLE_PROFILING.
+/// Otherwise, the macros compile to nothing and profiles are always empty.
+/// Scope and counter names must be string literals (or otherwise outlive the program).
+/// Scope names may only contain letters, digits and underscores.
+
+namespace LayoutEmbedding
+{
+
+struct ProfileEntry
+{
+    double seconds = 0.0; // Inclusive
+    int64_t calls = 0;
+    std::map<std::string, int64_t> counters; // Counted while this scope was the innermost one
+};
+
+/// Accumulated values per scope path (scope names joined by '/').
+/// Map order lists every scope right before its nested scopes (this relies on the restricted scope names).
+struct Profile
+{
+    std::map<std::string, ProfileEntry> entries;
+
+    bool empty() const { return entries.empty(); }
+
+    /// Values accumulated since _before was taken. Drops unchanged entries.
+    Profile operator-(const Profile& _before) const;
+
+    void print(std::ostream& _os = std::cout) const;
+};
+
+/// Everything accumulated by the calling thread so far (closed scopes only).
+Profile thread_profile();
+
+/// Discards the data of the calling thread. Must not be called while scopes are open.
+void reset_thread_profile();
+
+namespace profiling_detail
+{
+
+struct Node;
+
+Node* enter(const char* _name);
+void leave(Node* _node, const double _seconds);
+void count(const char* _name, const int64_t _n);
+
+}
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(const char* _name) :
+        node(profiling_detail::enter(_name)),
+        start(clock::now())
+    {
+    }
+
+    ~ProfileScope()
+    {
+        stop();
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+    /// Closes the scope before the end of the block. No other scope may be open inside.
+    void stop()
+    {
+        if (node) {
+            profiling_detail::leave(node, std::chrono::duration<double>(clock::now() - start).count());
+            node = nullptr;
+        }
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    profiling_detail::Node* node;
+    clock::time_point start;
+};
+
+}
+
+#define LE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define LE_PROFILE_CONCAT(a, b) LE_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef LE_ENABLE_PROFILING
+
+#define LE_PROFILE_SCOPE(name) ::LayoutEmbedding::ProfileScope LE_PROFILE_CONCAT(le_profile_scope_, __LINE__)(name)
+#define LE_PROFILE_NAMED_SCOPE(var, name) ::LayoutEmbedding::ProfileScope var(name)
+#define LE_PROFILE_STOP(var) var.stop()
+#define LE_PROFILE_COUNT(name, n) ::LayoutEmbedding::profiling_detail::count(name, n)
+#define LE_PROFILE_ONLY(...) __VA_ARGS__
+
+#else
+
+#define LE_PROFILE_SCOPE(name) do {} while (false)
+#define LE_PROFILE_NAMED_SCOPE(var, name) do {} while (false)
+#define LE_PROFILE_STOP(var) do {} while (false)
+#define LE_PROFILE_COUNT(name, n) do {} while (false)
+#define LE_PROFILE_ONLY(...)
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+
+namespace LayoutEmbedding
+{
+
+/// Wall clock timer, started on construction.
+class Timer
+{
+public:
+    Timer() : start(clock::now()) { }
+
+    void restart() { start = clock::now(); }
+
+    double elapsed_seconds() const
+    {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+private:
+    using clock = std::chrono::steady_clock;
+    clock::time_point start;
+};
+
+}
@@ -1,30 +1,135 @@
 #include "VertexRepulsiveEnergy.hh"
 
+#include <LayoutEmbedding/Embedding.hh>
 #include <LayoutEmbedding/Harmonic.hh>
+#include <LayoutEmbedding/Util/Assert.hh>
+
+#include <mutex>
 
 namespace LayoutEmbedding {
 
-Eigen::MatrixXd compute_vertex_repulsive_energy(const Embedding& _em)
+struct VertexRepulsiveEnergy::SharedFields
+{
+    int num_vertices = 0;
+    std::vector<int> t_v_of_l_v; // Constrained target vertex per layout vertex
+
+    HarmonicSolver solver;
+    bool iterative = false; // Too large for a direct factorization, see harmonic_max_direct_solve_size
+
+    std::vector<Eigen::VectorXd> values; // Per layout vertex, empty until solved for
+    std::vector<char> computed; // Per layout vertex
+    std::mutex mutex;
+};
+
+double VertexRepulsiveEnergy::Field::operator[](const pm::vertex_index& _t_v) const
+{
+    if (_t_v.value < num_base_vertices) {
+        return base_values[_t_v.value];
+    }
+    else {
+        LE_ASSERT_L(_t_v.value - num_base_vertices, num_interpolated_vertices);
+        return interpolated_values[_t_v.value - num_base_vertices];
+    }
+}
+
+VertexRepulsiveEnergy::VertexRepulsiveEnergy(const Embedding& _em) :
+    shared(std::make_shared<SharedFields>())
 {
     const int l_num_v = _em.layout_mesh().vertices().size();
     const int t_num_v = _em.target_mesh().vertices().size();
 
-    // Set up boundary conditions
-    auto constrained = _em.target_mesh().vertices().make_attribute<bool>(false);
-    Eigen::MatrixXd constraint_values = Eigen::MatrixXd::Zero(t_num_v, l_num_v);
+    shared->num_vertices = t_num_v;
+    shared->t_v_of_l_v.resize(l_num_v);
 
-    for (const auto l_v : _em.layout_mesh().vertices())
-    {
+    auto constrained = _em.target_mesh().vertices().make_attribute<bool>(false);
+    for (const auto l_v : _em.layout_mesh().vertices()) {
         const auto t_v = _em.matching_target_vertex(l_v);
         constrained[t_v] = true;
-        constraint_values(t_v.idx.value, l_v.idx.value) = 1.0;
+        shared->t_v_of_l_v[l_v.idx.value] = t_v.idx.value;
+    }
+
+    shared->solver.setup(_em.target_pos(), constrained, LaplaceWeights::MeanValue);
+    shared->iterative = shared->solver.num_free_vertices() > harmonic_max_direct_solve_size;
+    if (!shared->iterative) {
+        LE_ASSERT(shared->solver.factorize());
+    }
+
+    shared->values.resize(l_num_v);
+    shared->computed.resize(l_num_v, false);
+    interpolated_values.resize(l_num_v);
+}
+
+VertexRepulsiveEnergy::VertexRepulsiveEnergy(const VertexRepulsiveEnergy& _other)
+{
+    *this = _other;
+}
+
+VertexRepulsiveEnergy& VertexRepulsiveEnergy::operator=(const VertexRepulsiveEnergy& _other)
+{
+    if (this != &_other) {
+        std::lock_guard<std::mutex> lock(_other.interpolated_mutex);
+        shared = _other.shared;
+        interpolated = _other.interpolated;
+        interpolated_values = _other.interpolated_values;
+    }
+    return *this;
+}
+
+VertexRepulsiveEnergy::Field VertexRepulsiveEnergy::field(const pm::vertex_handle& _l_v) const
+{
+    const int col = _l_v.idx.value;
+    LE_ASSERT_L(col, (int)shared->t_v_of_l_v.size());
+
+    {
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        if (!shared->computed[col]) {
+            Eigen::MatrixXd constraint_values = Eigen::MatrixXd::Zero(shared->num_vertices, 1);
+            constraint_values(shared->t_v_of_l_v[col], 0) = 1.0;
+            Eigen::MatrixXd res;
+            if (shared->iterative) {
+                LE_ASSERT(shared->solver.solve_iterative(constraint_values, res));
+            }
+            else {
+                LE_ASSERT(shared->solver.solve(constraint_values, res));
+            }
+            shared->values[col] = res.col(0);
+            shared->computed[col] = true;
+        }
     }
 
-    // Compute l_num_v many harmonic fields
-    Eigen::MatrixXd W;
-    LE_ASSERT(harmonic(_em.target_pos(), constrained, constraint_values, W, LaplaceWeights::MeanValue));
+    // Resolve the vertices added since the last request of this field.
+    // Both parents of an interpolated vertex were created before it, so their values are already known.
+    const double* base_values = shared->values[col].data();
+    const int num_base_vertices = shared->num_vertices;
+    std::lock_guard<std::mutex> lock(interpolated_mutex);
+    auto& values = interpolated_values[col];
+    values.reserve(interpolated.size());
+    for (size_t i = values.size(); i < interpolated.size(); ++i) {
+        const auto& iv = interpolated[i];
+        const double val_a = iv.t_v_a < num_base_vertices ? base_values[iv.t_v_a] : values[iv.t_v_a - num_base_vertices];
+        const double val_b = iv.t_v_b < num_base_vertices ? base_values[iv.t_v_b] : values[iv.t_v_b - num_base_vertices];
+        values.push_back((1.0 - iv.lambda) * val_a + iv.lambda * val_b);
+    }
+
+    Field result;
+    result.base_values = base_values;
+    result.num_base_vertices = num_base_vertices;
+    result.interpolated_values = values.data();
+    result.num_interpolated_vertices = values.size();
+    return result;
+}
 
-    return W;
+void VertexRepulsiveEnergy::add_interpolated_vertex(const pm::vertex_handle& _t_v_new, const pm::vertex_handle& _t_v_a, const pm::vertex_handle& _t_v_b, const double _lambda)
+{
+    LE_ASSERT_EQ(_t_v_new.idx.value, num_vertices());
+    LE_ASSERT_L(_t_v_a.idx.value, num_vertices());
+    LE_ASSERT_L(_t_v_b.idx.value, num_vertices());
+    interpolated.push_back({_t_v_a.idx.value, _t_v_b.idx.value, _lambda});
+}
+
+int VertexRepulsiveEnergy::num_vertices() const
+{
+    return shared->num_vertices + interpolated.size();
 }
 
 }
@@ -1,11 +1,80 @@
 #pragma once
 
-#include <LayoutEmbedding/Embedding.hh>
+#include <polymesh/pm.hh>
 
 #include <Eigen/Dense>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace LayoutEmbedding {
 
-Eigen::MatrixXd compute_vertex_repulsive_energy(const Embedding& _em);
+class Embedding;
+
+/// Vertex repulsive energy fields [Praun2001], one per layout vertex:
+/// The harmonic function (mean value weights) on the target mesh that is 1 at the matching
+/// target vertex of the layout vertex and 0 at the matching target vertices of all other layout vertices.
+///
+/// The fields are stored per layout vertex over the target vertices present at construction.
+/// The reduced Laplacian is factorized once at construction (unless it exceeds harmonic_max_direct_solve_size,
+/// then fields are solved iteratively), individual fields are solved for (and allocated) on first access.
+/// The fields are shared (read-only, apart from the lazy evaluation) between copies.
+///
+/// Target vertices inserted later by edge splits are kept in an append-only side table (per copy),
+/// which linearly interpolates the values of the split edge's endpoints.
+/// The interpolated values are resolved in creation order per field (when it is requested), so lookups are O(1).
+class VertexRepulsiveEnergy
+{
+public:
+    struct InterpolatedVertex
+    {
+        int t_v_a;
+        int t_v_b;
+        double lambda; // Position between a (0.0) and b (1.0)
+    };
+
+    /// A single field, i.e. all values of the energy for one layout vertex.
+    /// Only valid as long as the VertexRepulsiveEnergy it came from is alive and no vertices are added.
+    class Field
+    {
+    public:
+        double operator[](const pm::vertex_index& _t_v) const;
+        double operator[](const pm::vertex_handle& _t_v) const { return (*this)[_t_v.idx]; }
+
+    private:
+        friend class VertexRepulsiveEnergy;
+
+        const double* base_values = nullptr;
+        int num_base_vertices = 0;
+        const double* interpolated_values = nullptr;
+        int num_interpolated_vertices = 0;
+    };
+
+    explicit VertexRepulsiveEnergy(const Embedding& _em);
+
+    VertexRepulsiveEnergy(const VertexRepulsiveEnergy& _other);
+    VertexRepulsiveEnergy& operator=(const VertexRepulsiveEnergy& _other);
+
+    /// Solves for the field of the given layout vertex if this did not happen yet. Thread safe.
+    Field field(const pm::vertex_handle& _l_v) const;
+
+    /// Registers a target vertex that was inserted on the edge between _t_v_a and _t_v_b.
+    /// Vertices have to be registered in the order of their creation.
+    void add_interpolated_vertex(const pm::vertex_handle& _t_v_new, const pm::vertex_handle& _t_v_a, const pm::vertex_handle& _t_v_b, const double _lambda);
+
+    int num_vertices() const;
+
+private:
+    struct SharedFields;
+
+    std::shared_ptr<SharedFields> shared;
+    std::vector<InterpolatedVertex> interpolated;
+
+    // Per layout vertex: Values of the field at the first (size) interpolated vertices.
+    // Extended by field(), covers all interpolated vertices after that.
+    mutable std::vector<std::vector<double>> interpolated_values;
+    mutable std::mutex interpolated_mutex; // Guards interpolated_values in field()
+};
 
 }
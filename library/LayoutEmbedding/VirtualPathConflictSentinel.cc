@@ -3,41 +3,99 @@
 #include <LayoutEmbedding/Util/Assert.hh>
 #include <LayoutEmbedding/Connectivity.hh>
 
+#include <algorithm>
 #include <unordered_map>
 
 namespace LayoutEmbedding {
 
+namespace {
+
+VirtualPathConflictSentinel::Workspace& thread_local_workspace()
+{
+    thread_local VirtualPathConflictSentinel::Workspace workspace;
+    return workspace;
+}
+
+}
+
+void SparseLabelMap::clear(int _num_elements)
+{
+    if (_num_elements > cell_generation.size()) {
+        cell_generation.resize(_num_elements, 0);
+        cell_slot.resize(_num_elements, -1);
+    }
+
+    ++generation;
+    if (generation == 0) {
+        // Wrap-around: Stamps from old generations could become valid again.
+        std::fill(cell_generation.begin(), cell_generation.end(), 0);
+        generation = 1;
+    }
+    n_touched = 0;
+}
+
+SparseLabelMap::LabelList& SparseLabelMap::touch(int _idx)
+{
+    LE_ASSERT_GEQ(_idx, 0);
+    LE_ASSERT_L(_idx, cell_generation.size());
+    if (cell_generation[_idx] != generation) {
+        // First access in this generation: Hand out a (cleared) list from the pool.
+        if (n_touched == slots.size()) {
+            slots.emplace_back();
+        }
+        slots[n_touched].clear();
+        cell_generation[_idx] = generation;
+        cell_slot[_idx] = n_touched;
+        ++n_touched;
+    }
+    return slots[cell_slot[_idx]];
+}
+
 VirtualPathConflictSentinel::VirtualPathConflictSentinel(const Embedding& _em) :
+    VirtualPathConflictSentinel(_em, thread_local_workspace())
+{
+}
+
+VirtualPathConflictSentinel::VirtualPathConflictSentinel(const Embedding& _em, Workspace& _workspace) :
     em(_em),
-    v_label(em.target_mesh()),
-    e_label(em.target_mesh()),
-    f_label(em.target_mesh()),
+    v_label(_workspace.v_label),
+    e_label(_workspace.e_label),
+    f_label(_workspace.f_label),
     l_port(em.layout_mesh())
 {
+    v_label.clear(em.target_mesh().all_vertices().size());
+    e_label.clear(em.target_mesh().all_edges().size());
+    f_label.clear(em.target_mesh().all_faces().size());
 }
 
-void VirtualPathConflictSentinel::insert(const pm::vertex_handle& _v, const VirtualPathConflictSentinel::Label& _l)
+void VirtualPathConflictSentinel::insert(SparseLabelMap& _labels, int _idx, const VirtualPathConflictSentinel::Label& _l)
 {
-    for (const auto& prev_l : v_label[_v]) {
+    LabelList& labels = _labels.touch(_idx);
+    bool contained = false;
+    for (const auto& prev_l : labels) {
         mark_conflicting(_l, prev_l);
+        if (prev_l == _l) {
+            contained = true;
+        }
+    }
+    if (!contained) {
+        labels.push_back(_l);
     }
-    v_label[_v].insert(_l);
+}
+
+void VirtualPathConflictSentinel::insert(const pm::vertex_handle& _v, const VirtualPathConflictSentinel::Label& _l)
+{
+    insert(v_label, _v.idx.value, _l);
 }
 
 void VirtualPathConflictSentinel::insert(const pm::edge_handle& _e, const VirtualPathConflictSentinel::Label& _l)
 {
-    for (const auto& prev_l : e_label[_e]) {
-        mark_conflicting(_l, prev_l);
-    }
-    e_label[_e].insert(_l);
+    insert(e_label, _e.idx.value, _l);
 }
 
 void VirtualPathConflictSentinel::insert(const pm::face_handle& _f, const VirtualPathConflictSentinel::Label& _l)
 {
-    for (const auto& prev_l : f_label[_f]) {
-        mark_conflicting(_l, prev_l);
-    }
-    f_label[_f].insert(_l);
+    insert(f_label, _f.idx.value, _l);
 }
 
 void VirtualPathConflictSentinel::insert_virtual_vertex(const VirtualVertex& _vv, const VirtualPathConflictSentinel::Label& _l)
@@ -6,28 +6,65 @@
 #include <LayoutEmbedding/VirtualVertex.hh>
 #include <LayoutEmbedding/VirtualVertexAttribute.hh>
 
+#include <set>
+#include <vector>
+
 namespace LayoutEmbedding {
 
+/// Sparse map from mesh element indices to small lists of labels.
+/// Storage is indexed densely, but a cell only counts as populated if it was touched
+/// since the last clear(). This is tracked via a generation stamp, so clearing is O(1)
+/// and a single instance can be reused across many conflict detection runs.
+struct SparseLabelMap
+{
+    using Label = pm::edge_index;
+    using LabelList = std::vector<Label>;
+
+    /// Invalidates all cells and makes sure that indices in [0, _num_elements) can be touched.
+    void clear(int _num_elements);
+
+    /// Labels stored in cell _idx. Marks the cell as populated.
+    LabelList& touch(int _idx);
+
+private:
+    std::vector<unsigned int> cell_generation;
+    std::vector<int> cell_slot;
+    std::vector<LabelList> slots; // Pool of label lists. Keeps its capacity across clear().
+    unsigned int generation = 0;
+    int n_touched = 0;
+};
+
 struct VirtualPathConflictSentinel
 {
     const Embedding& em;
 
     using Segment = std::pair<VirtualVertex, VirtualVertex>;
-    using Label = pm::edge_index;
-    using LabelSet = std::set<Label>;
+    using Label = SparseLabelMap::Label;
+    using LabelList = SparseLabelMap::LabelList;
 
     using Conflict = std::pair<Label, Label>;
     using ConflictSet = std::set<Conflict>;
 
-    pm::vertex_attribute<LabelSet> v_label;
-    pm::edge_attribute<LabelSet> e_label;
-    pm::face_attribute<LabelSet> f_label;
+    /// Per-element label storage. Reused by all sentinels constructed with the same workspace.
+    struct Workspace
+    {
+        SparseLabelMap v_label;
+        SparseLabelMap e_label;
+        SparseLabelMap f_label;
+    };
+
+    SparseLabelMap& v_label;
+    SparseLabelMap& e_label;
+    SparseLabelMap& f_label;
 
     ConflictSet conflict_relation; // The pairs of labels which are conflicting
 
     pm::halfedge_attribute<VirtualPort> l_port;
 
+    /// Uses a thread-local workspace.
+    /// Warning: Only one such sentinel may be alive per thread at any time.
     explicit VirtualPathConflictSentinel(const Embedding& _em);
+    VirtualPathConflictSentinel(const Embedding& _em, Workspace& _workspace);
 
     void insert(const pm::vertex_handle& _v, const Label& _l);
     void insert(const pm::edge_handle& _e, const Label& _l);
@@ -39,6 +76,9 @@ struct VirtualPathConflictSentinel
     void mark_conflicting(const Label& _a, const Label& _b);
 
     void check_path_ordering();
+
+private:
+    void insert(SparseLabelMap& _labels, int _idx, const Label& _l);
 };
 
 }
@@ -2,20 +2,62 @@
 
 #include <polymesh/pm.hh>
 
-#include <variant>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
 #include <vector>
 
 namespace LayoutEmbedding {
 
-using VirtualVertex = std::variant<
-    pm::vertex_index,
-    pm::edge_index
->;
+/// Either a vertex or an edge (midpoint) of the target mesh.
+/// Stored as a single tagged integer: The lowest bit holds the tag (0: vertex, 1: edge),
+/// the remaining bits hold the element index.
+/// The packed value can be used directly as an index into arrays that interleave
+/// per-vertex and per-edge data (see unified_index() and virtual_vertex_index_bound()).
+struct VirtualVertex
+{
+    VirtualVertex() = default; // Invalid (real) vertex
 
-bool is_valid(const VirtualVertex& _vv);
+    VirtualVertex(const pm::vertex_index& _v) : packed(_v.value * 2) { }
+    VirtualVertex(const pm::edge_index& _e) : packed(_e.value * 2 + 1) { }
+    VirtualVertex(const pm::vertex_handle& _v) : VirtualVertex(_v.idx) { }
+    VirtualVertex(const pm::edge_handle& _e) : VirtualVertex(_e.idx) { }
 
-bool is_real_vertex(const VirtualVertex& _el);
-bool is_real_edge(const VirtualVertex& _el);
+    static VirtualVertex from_unified_index(int _idx)
+    {
+        VirtualVertex result;
+        result.packed = _idx;
+        return result;
+    }
+
+    int unified_index() const { return packed; }
+
+    bool tag_is_edge() const { return (packed & 1) != 0; }
+    int element_index() const { return packed >> 1; } // Arithmetic shift keeps invalid indices at -1.
+
+    bool operator==(const VirtualVertex& _rhs) const { return packed == _rhs.packed; }
+    bool operator!=(const VirtualVertex& _rhs) const { return packed != _rhs.packed; }
+    bool operator<(const VirtualVertex& _rhs) const { return packed < _rhs.packed; }
+
+    std::int32_t packed = -2;
+};
+
+static_assert(sizeof(VirtualVertex) == 4, "VirtualVertex should be a packed 32 bit integer");
+
+inline bool is_valid(const VirtualVertex& _vv)
+{
+    return _vv.element_index() >= 0;
+}
+
+inline bool is_real_vertex(const VirtualVertex& _el)
+{
+    return !_el.tag_is_edge();
+}
+
+inline bool is_real_edge(const VirtualVertex& _el)
+{
+    return _el.tag_is_edge();
+}
 
 // Warning: These will throw when the contained element does not match.
 pm::vertex_index real_vertex(const VirtualVertex& _el);
@@ -25,4 +67,21 @@ pm::edge_index real_edge(const VirtualVertex& _el);
 pm::vertex_handle real_vertex(const VirtualVertex& _el, const pm::Mesh& _on_mesh);
 pm::edge_handle real_edge(const VirtualVertex& _el, const pm::Mesh& _on_mesh);
 
+/// Upper bound (exclusive) of VirtualVertex::unified_index() for all vertices and edges of _m.
+inline int virtual_vertex_index_bound(const pm::Mesh& _m)
+{
+    return 2 * std::max(_m.all_vertices().size(), _m.all_edges().size());
+}
+
+}
+
+namespace std
+{
+    template<> struct hash<LayoutEmbedding::VirtualVertex>
+    {
+        std::size_t operator()(const LayoutEmbedding::VirtualVertex& _x) const noexcept
+        {
+            return std::hash<std::int32_t>()(_x.packed);
+        }
+    };
 }
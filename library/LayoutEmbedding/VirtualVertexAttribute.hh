@@ -4,28 +4,31 @@
 
 #include <polymesh/pm.hh>
 
+#include <vector>
+
 namespace LayoutEmbedding {
 
+/// Flat per-VirtualVertex storage, indexed by VirtualVertex::unified_index().
+/// Warning: Unlike polymesh attributes, this does not grow with the mesh.
+/// It covers all vertices and edges present at construction time.
 template <typename T>
 struct VirtualVertexAttribute
 {
-    pm::vertex_attribute<T> v_a;
-    pm::edge_attribute<T> e_a;
+    std::vector<T> data;
 
-    VirtualVertexAttribute(const pm::Mesh& _m) :
-        v_a(_m),
-        e_a(_m)
+    explicit VirtualVertexAttribute(const pm::Mesh& _m, const T& _default = T()) :
+        data(virtual_vertex_index_bound(_m), _default)
     {
     }
 
     T& operator[](const VirtualVertex& _el)
     {
-        if (is_real_vertex(_el)) {
-            return v_a[real_vertex(_el)];
-        }
-        else {
-            return e_a[real_edge(_el)];
-        }
+        return data[_el.unified_index()];
+    }
+
+    const T& operator[](const VirtualVertex& _el) const
+    {
+        return data[_el.unified_index()];
     }
 };
 